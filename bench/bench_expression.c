@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+
+// Parses a program made of deeply nested arithmetic assignments, the case
+// where ExpressionResult is copied at every level of recursion.
+
+#define STATEMENTS 2000
+#define ROUNDS 20
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void append(char **buffer, size_t *length, size_t *capacity, const char *text){
+    size_t len = strlen(text);
+    while(*length + len + 1 > *capacity){
+        *capacity *= 2;
+        *buffer = realloc(*buffer, *capacity);
+    }
+    memcpy(*buffer + *length, text, len + 1);
+    *length += len;
+}
+
+//x := (1 + (2 * (3 - (... x ...)))) #
+static char *make_program(int depth, size_t *out_length){
+    size_t length = 0;
+    size_t capacity = 1024;
+    char *program = malloc(capacity);
+    program[0] = '\0';
+    const char *ops[] = {" + ", " * ", " - "};
+
+    append(&program, &length, &capacity, "FRG_Begin\nFRG_Int x #\nx := 1 #\n");
+    for(int s = 0; s < STATEMENTS; s++){
+        append(&program, &length, &capacity, "x := ");
+        for(int d = 0; d < depth; d++){
+            char term[32];
+            snprintf(term, sizeof(term), "(%d%s", d % 9 + 1, ops[d % 3]);
+            append(&program, &length, &capacity, term);
+        }
+        append(&program, &length, &capacity, "x");
+        for(int d = 0; d < depth; d++){
+            append(&program, &length, &capacity, ")");
+        }
+        append(&program, &length, &capacity, " #\n");
+    }
+    append(&program, &length, &capacity, "FRG_End\n");
+    *out_length = length;
+    return program;
+}
+
+int main(void){
+    const int depths[] = {4, 16, 64, 256};
+    printf("%-8s %-12s %-14s\n", "depth", "tokens", "parse ns/token");
+
+    for(size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++){
+        size_t length;
+        char *program = make_program(depths[d], &length);
+
+        TokenList tokens = {0};
+        ErrorList errors = {0};
+        lex_buffer(program, length, &tokens, &errors);
+
+        double best = 1e30;
+        for(int r = 0; r < ROUNDS; r++){
+            SymbolTable symbols = {0};
+            ErrorList parse_errors = {0};
+            Ast ast;
+            init_ast(&ast);
+            Parser parser;
+            init_parser(&parser, &tokens, &symbols, &parse_errors, &ast);
+
+            double start = now_seconds();
+            parse(&parser);
+            double elapsed = now_seconds() - start;
+            if(elapsed < best){
+                best = elapsed;
+            }
+
+            if(parse_errors.count != 0){
+                fprintf(stderr, "unexpected parse errors: %s\n", parse_errors.errors[0].err_message);
+                return 1;
+            }
+            free_ast(&ast);
+            free_error_list(&parse_errors);
+            free_symbol_table(&symbols);
+        }
+
+        printf("%-8d %-12d %-14.2f\n", depths[d], tokens.count, best * 1e9 / tokens.count);
+        free_token_list(&tokens);
+        free_error_list(&errors);
+        free(program);
+    }
+    return 0;
+}
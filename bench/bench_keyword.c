@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "../include/lexer.h"
+
+// Compares keyword_type() with the sequential equals_ignore_case chain the
+// lexer used before, over a word mix dominated by identifiers.
+
+#define ROUNDS 2000000
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int equals_ignore_case(const char *a, size_t len, const char *b){
+    size_t i = 0;
+    while(i < len && *b){
+        if(tolower((unsigned char)a[i]) != tolower((unsigned char)*b)){
+            return 0;
+        }
+        i++;
+        b++;
+    }
+    return i == len && *b == '\0';
+}
+
+static TokenType chain_keyword_type(const char *word, size_t len){
+    static const struct { const char *text; TokenType type; } keywords[] = {
+        {"FRG_Begin", KEYWORD_BEGIN}, {"FRG_End", KEYWORD_END}, {"FRG_Int", KEYWORD_INT},
+        {"FRG_Real", KEYWORD_REAL}, {"FRG_Strg", KEYWORD_STRING}, {"FRG_Print", KEYWORD_PRINT},
+        {"If", KEYWORD_IF}, {"Else", KEYWORD_ELSE}, {"Repeat", KEYWORD_REPEAT},
+        {"Until", KEYWORD_UNTIL}, {"Begin", BLOCK_BEGIN}, {"End", BLOCK_END}
+    };
+    for(size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++){
+        if(equals_ignore_case(word, len, keywords[i].text)){
+            return keywords[i].type;
+        }
+    }
+    return IDENTIFIER;
+}
+
+int main(void){
+    const char *words[] = {
+        "x1", "counter", "total", "i", "j", "FRG_Int", "value", "tmp", "sum",
+        "If", "result", "x3", "idx", "FRG_Print", "Repeat", "until", "average",
+        "End", "name", "frg_real", "Begin", "accumulator", "n", "else"
+    };
+    const int word_count = sizeof(words) / sizeof(words[0]);
+    size_t lengths[sizeof(words) / sizeof(words[0])];
+    for(int i = 0; i < word_count; i++){
+        lengths[i] = strlen(words[i]);
+        if(keyword_type(words[i], lengths[i]) != chain_keyword_type(words[i], lengths[i])){
+            fprintf(stderr, "mismatch on '%s'\n", words[i]);
+            return 1;
+        }
+    }
+
+    long checksum = 0;
+    double start = now_seconds();
+    for(int r = 0; r < ROUNDS; r++){
+        int w = r % word_count;
+        checksum += keyword_type(words[w], lengths[w]);
+    }
+    double dispatch = (now_seconds() - start) * 1e9 / ROUNDS;
+
+    start = now_seconds();
+    for(int r = 0; r < ROUNDS; r++){
+        int w = r % word_count;
+        checksum -= chain_keyword_type(words[w], lengths[w]);
+    }
+    double chain = (now_seconds() - start) * 1e9 / ROUNDS;
+
+    printf("keyword_type (length dispatch): %6.2f ns/word\n", dispatch);
+    printf("equals_ignore_case chain:       %6.2f ns/word\n", chain);
+    return checksum == 0 ? 0 : 1;
+}
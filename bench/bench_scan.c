@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "../include/lexer.h"
+#include "../include/scan.h"
+
+// Lexing throughput in GB/s over a generated program: the character-class
+// walk of the old byte-at-a-time loops (<ctype.h>), the same walk with the
+// scan_* functions, and the whole lexer.
+
+#define TARGET_BYTES (64 * 1024 * 1024)
+#define ROUNDS 5
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static char *generate_program(size_t *length){
+    const char *lines[] = {
+        "    FRG_Int counter_%d, accumulated_total_%d #\n",
+        "    accumulated_total_%d := accumulated_total_%d + counter_%d * 1234567 #\n",
+        "        FRG_Print \"value of the running total is\", accumulated_total_%d #\n",
+        "    ## comment number %d explaining what happens next %d\n",
+        "    If [counter_%d < 1000000.25] Begin average_value_%d := 3.14159 # End\n",
+        "\t\tRepeat counter_%d := counter_%d - 1 # until [counter_%d <= 0]\n"
+    };
+    size_t capacity = TARGET_BYTES + 4096;
+    char *text = malloc(capacity);
+    size_t used = 0;
+    used += (size_t)sprintf(text, "FRG_Begin\n");
+    for(int i = 0; used < TARGET_BYTES; i++){
+        used += (size_t)snprintf(text + used, capacity - used, lines[i % 6], i, i, i, i);
+    }
+    used += (size_t)snprintf(text + used, capacity - used, "FRG_End\n");
+    *length = used;
+    return text;
+}
+
+//the loops lex_line used before: one ctype call per byte
+static long ctype_walk(const char *text, size_t length){
+    long runs = 0;
+    size_t i = 0;
+    while(i < length){
+        char c = text[i];
+        if(c == ' ' || c == '\t'){
+            while(i < length && (text[i] == ' ' || text[i] == '\t')){
+                i++;
+            }
+        } else if(isalpha((unsigned char)c) || c == '_'){
+            while(i < length && (isalnum((unsigned char)text[i]) || text[i] == '_')){
+                i++;
+            }
+        } else if(isdigit((unsigned char)c)){
+            while(i < length && isdigit((unsigned char)text[i])){
+                i++;
+            }
+        } else if(c == '"'){
+            i++;
+            while(i < length && text[i] != '"' && text[i] != '\n'){
+                i++;
+            }
+            i++;
+        } else {
+            i++;
+        }
+        runs++;
+    }
+    return runs;
+}
+
+static long scan_walk(const char *text, size_t length){
+    long runs = 0;
+    size_t i = 0;
+    while(i < length){
+        char c = text[i];
+        if(scan_is(c, SCAN_BLANK)){
+            i += scan_blanks(text + i, length - i);
+        } else if(scan_is(c, SCAN_ALPHA)){
+            i += scan_identifier(text + i, length - i);
+        } else if(scan_is(c, SCAN_DIGIT)){
+            i += scan_digits(text + i, length - i);
+        } else if(c == '"'){
+            //strings never span lines, so the walk stops at whichever is first
+            i++;
+            size_t rest = length - i;
+            const char *newline = scan_find(text + i, rest, '\n');
+            size_t line_rest = newline ? (size_t)(newline - (text + i)) : rest;
+            const char *quote = scan_find(text + i, line_rest, '"');
+            i += quote ? (size_t)(quote - (text + i)) : line_rest;
+            i++;
+        } else {
+            i++;
+        }
+        runs++;
+    }
+    return runs;
+}
+
+static double best_seconds(long (*walk)(const char *, size_t), const char *text, size_t length, long *runs){
+    double best = 0;
+    for(int r = 0; r < ROUNDS; r++){
+        double start = now_seconds();
+        *runs = walk(text, length);
+        double elapsed = now_seconds() - start;
+        if(r == 0 || elapsed < best){
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+int main(void){
+    size_t length;
+    char *text = generate_program(&length);
+
+    long ctype_runs;
+    long scan_runs;
+    double ctype_seconds = best_seconds(ctype_walk, text, length, &ctype_runs);
+    double scan_seconds = best_seconds(scan_walk, text, length, &scan_runs);
+    if(ctype_runs != scan_runs){
+        fprintf(stderr, "walks disagree: %ld vs %ld runs\n", ctype_runs, scan_runs);
+        return 1;
+    }
+
+    double lex_seconds = 0;
+    int tokens = 0;
+    for(int r = 0; r < ROUNDS; r++){
+        TokenList tokenList = {0};
+        ErrorList errorList = {0};
+        double start = now_seconds();
+        lex_buffer(text, length, &tokenList, &errorList);
+        double elapsed = now_seconds() - start;
+        if(r == 0 || elapsed < lex_seconds){
+            lex_seconds = elapsed;
+        }
+        tokens = tokenList.count;
+        free_token_list(&tokenList);
+        free_error_list(&errorList);
+    }
+
+    double gigabytes = (double)length / 1e9;
+    printf("input: %.1f MB, %d tokens\n", (double)length / 1e6, tokens);
+    printf("class walk, <ctype.h> loops: %6.3f GB/s\n", gigabytes / ctype_seconds);
+    printf("class walk, scan_*:          %6.3f GB/s\n", gigabytes / scan_seconds);
+    printf("lex_buffer:                  %6.3f GB/s\n", gigabytes / lex_seconds);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/analysis.h"
+#include "../include/report.h"
+#include "generator.h"
+
+// Times the lexer, findSymbol, the parser and the report formatters on one
+// generated program and prints the results as JSON, so runs with different
+// generator options can be compared by scripts. Every benchmark reports the
+// best and median of the rounds and the cost per item (token, lookup or
+// output byte). Unless told otherwise the program carries a few errors per
+// thousand lines, since most of what the reports format is the error list.
+
+#define DEFAULT_ROUNDS 10
+#define DEFAULT_ERRORS 5    //per 1000 statements
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    const char *text;
+    size_t length;
+    Analysis *analysis;     //full pipeline results, input of the parse and report benchmarks
+    const char **names;     //identifier of every IDENTIFIER token, in source order
+    int name_count;
+    void (*report)(const Analysis *, OutputBuffer *);
+} Input;
+
+//one round of a benchmark; returns the number of items it processed
+typedef long (*BenchFunction)(const Input *input);
+
+static long bench_lex(const Input *input){
+    TokenList tokenList = {0};
+    ErrorList errorList = {0};
+    lex_buffer(input->text, input->length, &tokenList, &errorList);
+    long tokens = tokenList.count;
+    free_token_list(&tokenList);
+    free_error_list(&errorList);
+    return tokens;
+}
+
+static long bench_find_symbol(const Input *input){
+    SymbolTable *table = &input->analysis->symbolTable;
+    long found = 0;
+    for(int i = 0; i < input->name_count; i++){
+        found += findSymbol(table, input->names[i]) != NULL;
+    }
+    return found;
+}
+
+static long bench_parse(const Input *input){
+    SymbolTable symbolTable = {0};
+    ErrorList errorList = {0};
+    Ast ast;
+    init_ast(&ast);
+    Parser parser;
+    init_parser(&parser, &input->analysis->tokenList, &symbolTable, &errorList, &ast);
+    parse(&parser);
+    free_ast(&ast);
+    free_symbol_table(&symbolTable);
+    free_error_list(&errorList);
+    return input->analysis->tokenList.count;
+}
+
+static long bench_report(const Input *input){
+    OutputBuffer out;
+    init_output_buffer(&out);
+    input->report(input->analysis, &out);
+    long bytes = (long)out.length;
+    free_output_buffer(&out);
+    return bytes;
+}
+
+static int compare_doubles(const void *a, const void *b){
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_benchmark(const char *name, const char *unit, BenchFunction bench, const Input *input,
+                          int rounds, int *first){
+    double *seconds = malloc(sizeof(double) * rounds);
+    long items = 0;
+    for(int r = 0; r < rounds; r++){
+        double start = now_seconds();
+        items = bench(input);
+        seconds[r] = now_seconds() - start;
+    }
+    qsort(seconds, rounds, sizeof(double), compare_doubles);
+    double best = seconds[0];
+    double median = seconds[rounds / 2];
+    free(seconds);
+
+    printf("%s\n    {\"name\": \"%s\", \"items\": %ld, \"unit\": \"%s\", "
+           "\"best_ms\": %.3f, \"median_ms\": %.3f, \"ns_per_item\": %.2f, \"source_mb_per_s\": %.1f}",
+           *first ? "" : ",", name, items, unit, best * 1e3, median * 1e3,
+           items > 0 ? best * 1e9 / items : 0.0, (double)input->length / 1e6 / best);
+    *first = 0;
+}
+
+static void usage(const char *program){
+    fprintf(stderr, "usage: %s [--rounds=N] [--lines=N] [--identifiers=N] [--depth=N] [--nesting=N] [--string-size=N] [--errors=N] [--seed=N]\n", program);
+}
+
+int main(int argc, char *argv[]){
+    GeneratorOptions options;
+    default_generator_options(&options);
+    options.errors = DEFAULT_ERRORS;
+    int rounds = DEFAULT_ROUNDS;
+    for(int i = 1; i < argc; i++){
+        if(strncmp(argv[i], "--rounds=", 9) == 0){
+            rounds = atoi(argv[i] + 9);
+            if(rounds < 1){
+                usage(argv[0]);
+                return 2;
+            }
+        } else if(!parse_generator_option(&options, argv[i])){
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    Input input = {0};
+    char *text = generate_program(&options, &input.length);
+    input.text = text;
+    input.analysis = analyze_source(text, input.length, NULL, NULL);
+    if(options.errors == 0 && input.analysis->errorList.count != 0){
+        //the generator is broken, and the numbers would time the error paths
+        fprintf(stderr, "generated program has %d error(s)\n", input.analysis->errorList.count);
+        return 1;
+    }
+
+    TokenList *tokens = &input.analysis->tokenList;
+    input.names = malloc(sizeof(const char *) * (tokens->count + 1));
+    for(int i = 0; i < tokens->count; i++){
+        if(token_kind(tokens, i) == IDENTIFIER){
+            input.names[input.name_count++] = token_text(tokens, i);
+        }
+    }
+
+    int lines = 1;
+    for(size_t i = 0; i < input.length; i++){
+        lines += text[i] == '\n';
+    }
+    printf("{\n  \"program\": {\"lines\": %d, \"identifiers\": %d, \"depth\": %d, \"nesting\": %d, "
+           "\"string_size\": %d, \"errors\": %d, \"seed\": %u, \"bytes\": %zu, \"source_lines\": %d, "
+           "\"tokens\": %d, \"token_bytes\": %zu, \"error_count\": %d},\n",
+           options.lines, options.identifiers, options.depth, options.nesting, options.string_size,
+           options.errors, options.seed, input.length, lines, tokens->count, token_list_footprint(tokens), input.analysis->errorList.count);
+    printf("  \"rounds\": %d,\n  \"benchmarks\": [", rounds);
+
+    int first = 1;
+    run_benchmark("lex_buffer", "token", bench_lex, &input, rounds, &first);
+    run_benchmark("findSymbol", "lookup", bench_find_symbol, &input, rounds, &first);
+    run_benchmark("parse", "token", bench_parse, &input, rounds, &first);
+
+    const struct {
+        const char *name;
+        void (*report)(const Analysis *, OutputBuffer *);
+    } reports[] = {
+        {"lexical_report", write_lexical_report},
+        {"syntax_report", write_syntax_report},
+        {"semantic_report", write_semantic_report},
+        {"variables_report", write_variables_report}
+    };
+    for(size_t i = 0; i < sizeof(reports) / sizeof(reports[0]); i++){
+        input.report = reports[i].report;
+        run_benchmark(reports[i].name, "output byte", bench_report, &input, rounds, &first);
+    }
+    printf("\n  ]\n}\n");
+
+    free(input.names);
+    free_analysis(input.analysis);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/symbol.h"
+
+// Measures findSymbol() cost per lookup as the table grows. The linear scan
+// column is the previous implementation, kept here as the reference point.
+
+#define LOOKUPS 1000000
+
+static double now_seconds(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static Symbol *linear_find(SymbolTable *table, const char *id){
+    for(int i = 0; i < table->count; i++){
+        if(strcmp(table->symbols[i].id, id) == 0){
+            return &table->symbols[i];
+        }
+    }
+    return NULL;
+}
+
+int main(void){
+    const int sizes[] = {10, 100, 1000, 10000, 100000};
+    const int size_count = sizeof(sizes) / sizeof(sizes[0]);
+
+    printf("%-10s %-16s %-16s\n", "symbols", "hashed ns/op", "linear ns/op");
+    for(int s = 0; s < size_count; s++){
+        int n = sizes[s];
+        SymbolTable table = {0};
+        char **names = malloc(sizeof(char *) * n);
+        for(int i = 0; i < n; i++){
+            char name[32];
+            snprintf(name, sizeof(name), "var%d", i);
+            names[i] = malloc(strlen(name) + 1);
+            strcpy(names[i], name);
+            add_symbol(&table, create_symbol(name, KEY_INT, i + 1));
+        }
+
+        unsigned int seed = 12345;
+        int *order = malloc(sizeof(int) * LOOKUPS);
+        for(int i = 0; i < LOOKUPS; i++){
+            seed = seed * 1103515245u + 12345u;
+            order[i] = (int)((seed >> 8) % (unsigned int)n);
+        }
+
+        long found = 0;
+        double start = now_seconds();
+        for(int i = 0; i < LOOKUPS; i++){
+            found += findSymbol(&table, names[order[i]]) != NULL;
+        }
+        double hashed = (now_seconds() - start) * 1e9 / LOOKUPS;
+
+        // the linear scan is quadratic overall, so sample fewer lookups for big tables
+        int linear_lookups = n > 1000 ? LOOKUPS / (n / 100) : LOOKUPS;
+        start = now_seconds();
+        for(int i = 0; i < linear_lookups; i++){
+            found += linear_find(&table, names[order[i]]) != NULL;
+        }
+        double linear = (now_seconds() - start) * 1e9 / linear_lookups;
+
+        if(found != LOOKUPS + linear_lookups){
+            fprintf(stderr, "lookup mismatch at %d symbols\n", n);
+            return 1;
+        }
+        printf("%-10d %-16.1f %-16.1f\n", n, hashed, linear);
+
+        for(int i = 0; i < n; i++){
+            free(names[i]);
+        }
+        free(names);
+        free(order);
+        free_symbol_table(&table);
+    }
+    return 0;
+}
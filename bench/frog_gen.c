@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generator.h"
+
+// Writes a synthetic program to stdout, so the benchmark inputs can also be
+// fed to frogc or opened in the GUI.
+
+static void usage(const char *program){
+    fprintf(stderr, "usage: %s [--lines=N] [--identifiers=N] [--depth=N] [--nesting=N] [--string-size=N] [--errors=N] [--seed=N]\n", program);
+}
+
+int main(int argc, char *argv[]){
+    GeneratorOptions options;
+    default_generator_options(&options);
+    for(int i = 1; i < argc; i++){
+        if(!parse_generator_option(&options, argv[i])){
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    size_t length;
+    char *text = generate_program(&options, &length);
+    fwrite(text, 1, length, stdout);
+    free(text);
+    return 0;
+}
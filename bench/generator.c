@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "generator.h"
+
+// Synthetic FROG programs for the benchmarks. Half of the variables are
+// inputs that are assigned once and only read afterwards, the rest are
+// outputs that are only written, so values stay bounded and the program runs
+// to the end whatever the options: * and / only ever take the literal 2 and
+// every Repeat loop runs once.
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    int lines;
+    unsigned int state;
+} Generator;
+
+static void emit(Generator *gen, const char *format, ...){
+    while(1){
+        va_list args;
+        va_start(args, format);
+        size_t room = gen->capacity - gen->length;
+        int written = vsnprintf(gen->data + gen->length, room, format, args);
+        va_end(args);
+        if(written < 0){
+            return;
+        }
+        if((size_t)written < room){
+            gen->length += (size_t)written;
+            break;
+        }
+        gen->capacity = gen->capacity * 2 + (size_t)written;
+        gen->data = realloc(gen->data, gen->capacity);
+    }
+}
+
+static void emit_line(Generator *gen, int level, const char *format, ...){
+    for(int i = 0; i < level; i++){
+        emit(gen, "    ");
+    }
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    emit(gen, "%s\n", line);
+    gen->lines++;
+}
+
+static unsigned int next_random(Generator *gen){
+    //xorshift32, so programs do not depend on the C library's rand()
+    unsigned int x = gen->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen->state = x;
+    return x;
+}
+
+static int pick(Generator *gen, int count){
+    return (int)(next_random(gen) % (unsigned int)count);
+}
+
+typedef struct {
+    int inputs;
+    int outputs;
+    int reals;
+} Variables;
+
+static void emit_input(Generator *gen, const Variables *vars){
+    emit(gen, "input_%d", pick(gen, vars->inputs));
+}
+
+//division makes the expression real, so int targets only get the others
+static void emit_expression(Generator *gen, const Variables *vars, int depth, int real){
+    if(depth <= 0){
+        if(pick(gen, 3) == 0){
+            emit(gen, "%d", 1 + pick(gen, 99));
+        } else {
+            emit_input(gen, vars);
+        }
+        return;
+    }
+    emit(gen, "(");
+    emit_expression(gen, vars, depth - 1, real);
+    int op = real ? pick(gen, 6) : 1 + pick(gen, 5);
+    switch(op){
+        case 0:
+            emit(gen, " / 2");
+            break;
+        case 1:
+            emit(gen, " * 2");
+            break;
+        default:
+            emit(gen, pick(gen, 2) ? " + " : " - ");
+            emit_expression(gen, vars, 0, real);
+            break;
+    }
+    emit(gen, ")");
+}
+
+static void emit_string(Generator *gen, int size){
+    static const char words[] = "lorem ipsum dolor sit amet consectetur adipiscing elit ";
+    const int word_length = (int)(sizeof(words) - 1);
+    emit(gen, "\"");
+    for(int done = 0; done < size; done += word_length){
+        int part = size - done < word_length ? size - done : word_length;
+        emit(gen, "%.*s", part, words);
+    }
+    emit(gen, "\"");
+}
+
+static void emit_statement(Generator *gen, const GeneratorOptions *options, const Variables *vars, int level);
+
+static void emit_body(Generator *gen, const GeneratorOptions *options, const Variables *vars, int level){
+    int count = 1 + pick(gen, 3);
+    for(int i = 0; i < count; i++){
+        emit_statement(gen, options, vars, level);
+    }
+}
+
+//one lexical, syntax or semantic error, each confined to its own line
+static void emit_error(Generator *gen, const Variables *vars){
+    switch(pick(gen, 3)){
+        case 0:
+            emit(gen, "output_%d := input_%d @ 2 #\n", pick(gen, vars->outputs), pick(gen, vars->inputs));
+            break;
+        case 1:
+            emit(gen, "output_%d := * #\n", pick(gen, vars->outputs));
+            break;
+        default:
+            emit(gen, "undeclared_%d := 1 #\n", pick(gen, 1000));
+            break;
+    }
+    gen->lines++;
+}
+
+static void emit_statement(Generator *gen, const GeneratorOptions *options, const Variables *vars, int level){
+    if(options->errors > 0 && pick(gen, 1000) < options->errors){
+        for(int i = 0; i < level; i++){
+            emit(gen, "    ");
+        }
+        emit_error(gen, vars);
+        return;
+    }
+    int choice = pick(gen, 12);
+    if(choice >= 9 && level >= options->nesting){
+        choice = 0;
+    }
+    //statements are written piecewise, so the indentation is emitted here
+    for(int i = 0; i < level; i++){
+        emit(gen, "    ");
+    }
+    if(choice <= 5){
+        int depth = options->depth > 0 ? 1 + pick(gen, options->depth) : 0;
+        if(vars->reals > 0 && choice == 5){
+            emit(gen, "ratio_%d := ", pick(gen, vars->reals));
+            emit_expression(gen, vars, depth, 1);
+            emit(gen, " * 0.5 #\n");
+        } else {
+            emit(gen, "output_%d := ", pick(gen, vars->outputs));
+            emit_expression(gen, vars, depth, 0);
+            emit(gen, " #\n");
+        }
+    } else if(choice == 6){
+        emit(gen, "FRG_Print ");
+        emit_string(gen, options->string_size);
+        emit(gen, ", ");
+        emit_input(gen, vars);
+        emit(gen, " #\n");
+    } else if(choice <= 8){
+        emit(gen, "## step %d of the generated program\n", gen->lines);
+    } else if(choice <= 10){
+        emit(gen, "If [ ");
+        emit_input(gen, vars);
+        emit(gen, " < %d ]\n", 1 + pick(gen, 99));
+        gen->lines++;
+        emit_line(gen, level, "Begin");
+        emit_body(gen, options, vars, level + 1);
+        emit_line(gen, level, "End");
+        if(pick(gen, 2)){
+            emit_line(gen, level, "Else");
+            emit_statement(gen, options, vars, level + 1);
+        }
+        return;
+    } else {
+        emit(gen, "Repeat\n");
+        gen->lines++;
+        emit_body(gen, options, vars, level + 1);
+        int index = pick(gen, vars->inputs);
+        emit_line(gen, level, "until [ input_%d = input_%d ]", index, index);
+        return;
+    }
+    gen->lines++;
+}
+
+//comma separated names, a few per line
+static void emit_declarations(Generator *gen, const char *keyword, const char *prefix, int count){
+    const int per_line = 8;
+    for(int first = 0; first < count; first += per_line){
+        emit(gen, "%s ", keyword);
+        for(int i = first; i < count && i < first + per_line; i++){
+            emit(gen, i > first ? ", %s_%d" : "%s_%d", prefix, i);
+        }
+        emit(gen, " #\n");
+        gen->lines++;
+    }
+}
+
+void default_generator_options(GeneratorOptions *options){
+    options->lines = 10000;
+    options->identifiers = 200;
+    options->depth = 4;
+    options->nesting = 3;
+    options->string_size = 16;
+    options->errors = 0;
+    options->seed = 1;
+}
+
+int parse_generator_option(GeneratorOptions *options, const char *arg){
+    static const struct {
+        const char *name;
+        size_t offset;
+    } fields[] = {
+        {"--lines=", offsetof(GeneratorOptions, lines)},
+        {"--identifiers=", offsetof(GeneratorOptions, identifiers)},
+        {"--depth=", offsetof(GeneratorOptions, depth)},
+        {"--nesting=", offsetof(GeneratorOptions, nesting)},
+        {"--string-size=", offsetof(GeneratorOptions, string_size)},
+        {"--errors=", offsetof(GeneratorOptions, errors)}
+    };
+    if(strncmp(arg, "--seed=", 7) == 0){
+        options->seed = (unsigned int)strtoul(arg + 7, NULL, 10);
+        return 1;
+    }
+    for(size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++){
+        size_t length = strlen(fields[i].name);
+        if(strncmp(arg, fields[i].name, length) == 0){
+            char *end;
+            long value = strtol(arg + length, &end, 10);
+            if(*end != '\0' || end == arg + length || value < 0 || value > 100000000){
+                return 0;
+            }
+            *(int *)((char *)options + fields[i].offset) = (int)value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+char *generate_program(const GeneratorOptions *options, size_t *length){
+    Generator gen = {0};
+    gen.capacity = (size_t)(options->lines > 0 ? options->lines : 1) * 48 + 4096;
+    gen.data = malloc(gen.capacity);
+    gen.state = options->seed != 0 ? options->seed : 1;
+
+    //at least one input and one output, whatever the identifier count
+    Variables vars;
+    int identifiers = options->identifiers > 2 ? options->identifiers : 2;
+    vars.reals = identifiers / 8;
+    vars.inputs = (identifiers - vars.reals) / 2;
+    vars.outputs = identifiers - vars.reals - vars.inputs;
+
+    emit_line(&gen, 0, "FRG_Begin");
+    emit_line(&gen, 0, "## generated with seed %u", options->seed);
+    emit_declarations(&gen, "FRG_Int", "input", vars.inputs);
+    emit_declarations(&gen, "FRG_Int", "output", vars.outputs);
+    emit_declarations(&gen, "FRG_Real", "ratio", vars.reals);
+    for(int i = 0; i < vars.inputs; i++){
+        emit_line(&gen, 0, "input_%d := %d #", i, 1 + pick(&gen, 99));
+    }
+    while(gen.lines < options->lines - 1){
+        emit_statement(&gen, options, &vars, 0);
+    }
+    emit_line(&gen, 0, "FRG_End");
+
+    *length = gen.length;
+    return gen.data;
+}
@@ -0,0 +1,28 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stddef.h>
+
+//shape of a synthetic FROG program; every knob scales one cost of the
+//pipeline independently of the others
+typedef struct {
+    int lines;          //approximate number of source lines
+    int identifiers;    //distinct variables, all declared up front
+    int depth;          //nesting depth of arithmetic expressions
+    int nesting;        //deepest If/Repeat nesting
+    int string_size;    //length of each string literal
+    int errors;         //broken statements per 1000, so the reports have something to list
+    unsigned int seed;  //same options and seed give the same program
+} GeneratorOptions;
+
+void default_generator_options(GeneratorOptions *options);
+
+//parses one "--name=value" argument into options; returns 0 if arg is not a
+//generator option or its value is invalid
+int parse_generator_option(GeneratorOptions *options, const char *arg);
+
+//the program as a malloc'd NUL-terminated string; with errors set to 0 it
+//lexes, parses and runs without a single error
+char *generate_program(const GeneratorOptions *options, size_t *length);
+
+#endif
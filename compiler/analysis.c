@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/analysis.h"
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/bytecode.h"
+
+// Runs lexing, parsing, optimization and execution once and keeps every
+// result, so each view can be rendered without redoing the work.
+
+static int is_cancelled(CancelCheck cancelled, void *cancel_data){
+    return cancelled != NULL && cancelled(cancel_data);
+}
+
+Analysis *new_analysis(void){
+    Analysis *analysis = calloc(1, sizeof(Analysis));
+    init_ast(&analysis->ast);
+    init_optimization_report(&analysis->optimization);
+    init_chunk(&analysis->chunk);
+    init_output_buffer(&analysis->output);
+    return analysis;
+}
+
+//empties the analysis and refills it from data. Lists keep their memory from
+//the previous run, so re-analyzing sources of a similar size allocates
+//nothing new. Returns 0 if cancelled between two passes, leaving the
+//analysis incomplete.
+int run_analysis(Analysis *analysis, const char *data, size_t length, CancelCheck cancelled, void *cancel_data){
+    clear_token_list(&analysis->tokenList);
+    clear_error_list(&analysis->errorList);
+    clear_symbol_table(&analysis->symbolTable);
+    clear_ast(&analysis->ast);
+    clear_optimization_report(&analysis->optimization);
+    clear_chunk(&analysis->chunk);
+    clear_output_buffer(&analysis->output);
+    reserve_token_list(&analysis->tokenList, estimate_token_count(length));
+    analysis->content_length = length;
+
+    lex_buffer(data, length, &analysis->tokenList, &analysis->errorList);
+    if(is_cancelled(cancelled, cancel_data)){
+        return 0;
+    }
+
+    Parser parser;
+    init_parser(&parser, &analysis->tokenList, &analysis->symbolTable, &analysis->errorList, &analysis->ast);
+    parse(&parser);
+    optimize_program(&analysis->ast, &analysis->optimization);
+    if(is_cancelled(cancelled, cancel_data)){
+        return 0;
+    }
+
+    compile_program(&analysis->ast, &analysis->symbolTable, &analysis->chunk);
+    run_chunk(&analysis->chunk, &analysis->symbolTable, &analysis->errorList, &analysis->tokenList.lines, &analysis->output);
+    return 1;
+}
+
+//returns NULL if cancelled between two passes
+Analysis *analyze_source(const char *data, size_t length, CancelCheck cancelled, void *cancel_data){
+    Analysis *analysis = new_analysis();
+    if(!run_analysis(analysis, data, length, cancelled, cancel_data)){
+        free_analysis(analysis);
+        return NULL;
+    }
+    return analysis;
+}
+
+void free_analysis(Analysis *analysis){
+    if(analysis == NULL){
+        return;
+    }
+    free_token_list(&analysis->tokenList);
+    free_error_list(&analysis->errorList);
+    free_symbol_table(&analysis->symbolTable);
+    free_ast(&analysis->ast);
+    free_optimization_report(&analysis->optimization);
+    free_chunk(&analysis->chunk);
+    free_output_buffer(&analysis->output);
+    free(analysis);
+}
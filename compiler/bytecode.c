@@ -0,0 +1,232 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/bytecode.h"
+
+// Compiles the AST into a flat instruction stream for the VM in vm.c.
+// Variables become slots indexed by their SymbolTable position.
+
+typedef struct {
+    const Ast *ast;
+    const SymbolTable *symbolTable;
+    Chunk *chunk;
+    int depth;
+} Compiler;
+
+void init_chunk(Chunk *chunk){
+    memset(chunk, 0, sizeof(*chunk));
+}
+
+//empties the chunk for another compile_program, keeping its arrays
+void clear_chunk(Chunk *chunk){
+    chunk->count = 0;
+    chunk->constant_count = 0;
+    chunk->slot_count = 0;
+    chunk->loop_count = 0;
+    chunk->max_stack = 0;
+}
+
+void free_chunk(Chunk *chunk){
+    if(chunk == NULL){
+        return;
+    }
+    free(chunk->code);
+    free(chunk->lines);
+    free(chunk->constants);
+    free(chunk->slots);
+    free(chunk->stack);
+    free(chunk->loops);
+    init_chunk(chunk);
+}
+
+//stack effect of each opcode, used to size the VM stack at compile time
+static int stack_effect(OpCode op, int a){
+    switch(op){
+        case OP_CONST:
+        case OP_UNDEF:
+        case OP_LOAD:
+            return 1;
+        case OP_STORE:
+        case OP_STORE_REAL:
+        case OP_POP:
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_COMPARE:
+        case OP_BRANCH:
+        case OP_REPEAT_BACK:
+            return -1;
+        case OP_PRINT:
+            return -a;
+        default:
+            return 0;
+    }
+}
+
+static int emit(Compiler *c, OpCode op, int a, int b, int line){
+    Chunk *chunk = c->chunk;
+    if(chunk->count >= chunk->capacity){
+        chunk->capacity = chunk->capacity == 0 ? 64 : chunk->capacity * 2;
+        chunk->code = realloc(chunk->code, sizeof(Instruction) * chunk->capacity);
+        chunk->lines = realloc(chunk->lines, sizeof(int) * chunk->capacity);
+    }
+    chunk->code[chunk->count].op = (unsigned char)op;
+    chunk->code[chunk->count].a = a;
+    chunk->code[chunk->count].b = b;
+    chunk->lines[chunk->count] = line;
+
+    c->depth += stack_effect(op, a);
+    if(c->depth > chunk->max_stack){
+        chunk->max_stack = c->depth;
+    }
+    return chunk->count++;
+}
+
+static int add_constant(Compiler *c, Value value){
+    Chunk *chunk = c->chunk;
+    if(chunk->constant_count >= chunk->constant_capacity){
+        chunk->constant_capacity = chunk->constant_capacity == 0 ? 16 : chunk->constant_capacity * 2;
+        chunk->constants = realloc(chunk->constants, sizeof(Value) * chunk->constant_capacity);
+    }
+    chunk->constants[chunk->constant_count] = value;
+    return chunk->constant_count++;
+}
+
+static void compile_expression(Compiler *c, int index){
+    if(index < 0){
+        emit(c, OP_UNDEF, 0, 0, 0);
+        return;
+    }
+
+    const AstNode *node = &c->ast->nodes[index];
+    Value constant;
+    switch(node->kind){
+        case AST_INT_LITERAL:
+            constant = int_value(node->literal.integer);
+            emit(c, OP_CONST, add_constant(c, constant), 0, node->line);
+            break;
+        case AST_REAL_LITERAL:
+            constant = real_value(node->literal.number);
+            emit(c, OP_CONST, add_constant(c, constant), 0, node->line);
+            break;
+        case AST_STRING_LITERAL:
+            constant = string_value(node->literal.text);
+            emit(c, OP_CONST, add_constant(c, constant), 0, node->line);
+            break;
+        case AST_VARIABLE:
+            if(node->symbol < 0){
+                emit(c, OP_UNDEF, 0, 0, node->line);
+            } else {
+                emit(c, OP_LOAD, node->symbol, 0, node->line);
+            }
+            break;
+        case AST_NEGATE:
+            compile_expression(c, node->left);
+            emit(c, OP_NEG, 0, 0, node->line);
+            break;
+        case AST_BINARY: {
+            compile_expression(c, node->left);
+            compile_expression(c, node->right);
+            OpCode op = OP_DIV;
+            switch(node->op){
+                case OPERATOR_PLUS: op = OP_ADD; break;
+                case OPERATOR_MINUS: op = OP_SUB; break;
+                case OPERATOR_MULTIPLY: op = OP_MUL; break;
+                default: break;
+            }
+            emit(c, op, 0, 0, node->line);
+            break;
+        }
+        default:
+            emit(c, OP_UNDEF, 0, 0, node->line);
+            break;
+    }
+}
+
+static void compile_condition(Compiler *c, int index){
+    if(index < 0){
+        emit(c, OP_UNDEF, 0, 0, 0);
+        return;
+    }
+    const AstNode *node = &c->ast->nodes[index];
+    compile_expression(c, node->left);
+    compile_expression(c, node->right);
+    emit(c, OP_COMPARE, node->op, 0, node->line);
+}
+
+static void compile_statement(Compiler *c, int index);
+
+static void compile_children(Compiler *c, const AstNode *node){
+    for(int i = 0; i < node->child_count; i++){
+        compile_statement(c, c->ast->children[node->first_child + i]);
+    }
+}
+
+static void compile_statement(Compiler *c, int index){
+    if(index < 0){
+        return;
+    }
+
+    const AstNode *node = &c->ast->nodes[index];
+    switch(node->kind){
+        case AST_PROGRAM:
+        case AST_BLOCK:
+        case AST_DECLARATION:
+            compile_children(c, node);
+            break;
+        case AST_ASSIGN:
+            compile_expression(c, node->left);
+            if(node->symbol < 0){
+                emit(c, OP_POP, 0, 0, node->line);
+            } else if(c->symbolTable->symbols[node->symbol].type == KEY_REAL){
+                emit(c, OP_STORE_REAL, node->symbol, 0, node->line);
+            } else {
+                emit(c, OP_STORE, node->symbol, 0, node->line);
+            }
+            break;
+        case AST_PRINT:
+            for(int i = 0; i < node->child_count; i++){
+                compile_expression(c, c->ast->children[node->first_child + i]);
+            }
+            if(node->child_count > 0){
+                emit(c, OP_PRINT, node->child_count, 0, node->line);
+            }
+            break;
+        case AST_IF: {
+            compile_condition(c, node->left);
+            int branch = emit(c, OP_BRANCH, 0, 0, node->line);
+            compile_statement(c, node->right);
+            int skip_else = emit(c, OP_JUMP, 0, 0, node->line);
+            c->chunk->code[branch].a = c->chunk->count;
+            compile_statement(c, node->extra);
+            c->chunk->code[skip_else].a = c->chunk->count;
+            c->chunk->code[branch].b = c->chunk->count;
+            break;
+        }
+        case AST_REPEAT: {
+            int loop = c->chunk->loop_count++;
+            emit(c, OP_REPEAT_ENTER, loop, 0, node->line);
+            int start = c->chunk->count;
+            compile_children(c, node);
+            compile_condition(c, node->left);
+            emit(c, OP_REPEAT_BACK, loop, start, node->line);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void compile_program(const Ast *ast, const SymbolTable *symbolTable, Chunk *chunk){
+    Compiler c;
+    c.ast = ast;
+    c.symbolTable = symbolTable;
+    c.chunk = chunk;
+    c.depth = 0;
+
+    chunk->slot_count = symbolTable->count;
+    if(ast != NULL){
+        compile_statement(&c, ast->root);
+    }
+    emit(&c, OP_HALT, 0, 0, 0);
+}
@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#include "../include/cache.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_directory(path) _mkdir(path)
+#else
+#define make_directory(path) mkdir(path, 0777)
+#endif
+
+static const char cache_magic[8] = {'F', 'R', 'G', 'C', 'A', 'C', 'H', 'E'};
+
+//64 bit words through a multiply and xorshift, then a final mix; every step
+//is invertible, so two sources that differ in one word never collide
+unsigned long long hash_content(const char *data, size_t length){
+    unsigned long long hash = 0x9e3779b97f4a7c15ULL ^ (unsigned long long)length;
+    size_t i = 0;
+    for(; i + 8 <= length; i += 8){
+        unsigned long long word;
+        memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 32;
+    }
+    if(i < length){
+        unsigned long long word = 0;
+        memcpy(&word, data + i, length - i);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 32;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static char *cache_path(const AnalysisCache *cache, const char *name){
+    size_t size = strlen(cache->directory) + strlen(name) + 2;
+    char *path = malloc(size);
+    snprintf(path, size, "%s/%s", cache->directory, name);
+    return path;
+}
+
+static char *entry_path(const AnalysisCache *cache, unsigned long long hash){
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.frgc", hash);
+    return cache_path(cache, name);
+}
+
+int open_cache(AnalysisCache *cache, const char *directory, const char *identity, size_t limit){
+    memset(cache, 0, sizeof(*cache));
+    struct stat st;
+    if(stat(directory, &st) != 0){
+        make_directory(directory);
+        if(stat(directory, &st) != 0){
+            return 0;
+        }
+    }
+    if(!S_ISDIR(st.st_mode)){
+        return 0;
+    }
+    cache->directory = malloc(strlen(directory) + 1);
+    strcpy(cache->directory, directory);
+    snprintf(cache->identity, sizeof(cache->identity), "%s", identity);
+    cache->limit = limit;
+    return 1;
+}
+
+void close_cache(AnalysisCache *cache){
+    free(cache->directory);
+    cache->directory = NULL;
+}
+
+//count items of item_size at offset lie within the entry
+static int section_fits(const CacheHeader *header, unsigned int offset, unsigned int count, size_t item_size){
+    return offset % 8 == 0 && offset >= sizeof(CacheHeader)
+        && (unsigned long long)offset + (unsigned long long)count * item_size <= header->size;
+}
+
+static int validate_entry(const AnalysisCache *cache, unsigned long long hash, size_t length, CacheEntry *entry){
+    const char *data = entry->file.data;
+    if(entry->file.length < sizeof(CacheHeader)){
+        return 0;
+    }
+    const CacheHeader *header = (const CacheHeader *)data;
+    if(memcmp(header->magic, cache_magic, sizeof(cache_magic)) != 0 || header->format != CACHE_FORMAT
+       || header->size != entry->file.length
+       || strncmp(header->identity, cache->identity, CACHE_IDENTITY_SIZE) != 0
+       || header->content_hash != hash || header->content_length != (unsigned long long)length){
+        return 0;
+    }
+    //a torn or corrupted write shows in the body's hash
+    if(hash_content(data + sizeof(CacheHeader), header->size - sizeof(CacheHeader)) != header->body_hash){
+        return 0;
+    }
+    if(!section_fits(header, header->kinds, header->token_count, 1)
+       || !section_fits(header, header->offsets, header->token_count, sizeof(unsigned int))
+       || !section_fits(header, header->texts, header->text_count, sizeof(int))
+       || !section_fits(header, header->lines, header->line_count, sizeof(unsigned int))
+       || !section_fits(header, header->strings, header->string_count, sizeof(unsigned int))
+       || !section_fits(header, header->errors, header->error_count, sizeof(CachedError))
+       || !section_fits(header, header->blob, header->blob_size, 1)){
+        return 0;
+    }
+
+    entry->header = header;
+    entry->kinds = (const unsigned char *)(data + header->kinds);
+    entry->offsets = (const unsigned int *)(data + header->offsets);
+    entry->texts = (const int *)(data + header->texts);
+    entry->lines = (const unsigned int *)(data + header->lines);
+    entry->strings = (const unsigned int *)(data + header->strings);
+    entry->errors = (const CachedError *)(data + header->errors);
+    entry->blob = data + header->blob;
+
+    //every blob reference must land on a string that ends inside the blob
+    unsigned int blob_size = header->blob_size;
+    if(blob_size > 0 && entry->blob[blob_size - 1] != '\0'){
+        return 0;
+    }
+    for(unsigned int i = 0; i < header->string_count; i++){
+        if(entry->strings[i] >= blob_size){
+            return 0;
+        }
+    }
+    for(unsigned int i = 0; i < header->error_count; i++){
+        if(entry->errors[i].message >= blob_size || entry->errors[i].type > SEMANTIC_ERR){
+            return 0;
+        }
+    }
+    //offsets are looked up in the source, and the line map and the tokens
+    //are searched by bisection. Errors are grouped by pass, so only their
+    //bounds are checked.
+    for(unsigned int i = 0; i < header->line_count; i++){
+        if(entry->lines[i] > length || (i > 0 && entry->lines[i] < entry->lines[i - 1])){
+            return 0;
+        }
+    }
+    for(unsigned int i = 0; i < header->token_count; i++){
+        if(entry->offsets[i] > length || (i > 0 && entry->offsets[i] < entry->offsets[i - 1])){
+            return 0;
+        }
+    }
+    for(unsigned int i = 0; i < header->error_count; i++){
+        if(entry->errors[i].offset != NO_SOURCE_OFFSET && entry->errors[i].offset > length){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int load_cache_entry(const AnalysisCache *cache, unsigned long long hash, size_t length, CacheEntry *entry){
+    memset(entry, 0, sizeof(*entry));
+    char *path = entry_path(cache, hash);
+    if(!load_source_file(path, &entry->file)){
+        free(path);
+        return 0;
+    }
+    if(!validate_entry(cache, hash, length, entry)){
+        release_cache_entry(entry);
+        remove(path);
+        free(path);
+        return 0;
+    }
+    //the modification time orders entries for trim_cache
+    utime(path, NULL);
+    free(path);
+    return 1;
+}
+
+void release_cache_entry(CacheEntry *entry){
+    free_source_file(&entry->file);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void cached_line_map(const CacheEntry *entry, LineMap *lines){
+    for(unsigned int i = 0; i < entry->header->line_count; i++){
+        add_line_start(lines, entry->lines[i]);
+    }
+}
+
+int cached_tokens(const CacheEntry *entry, TokenList *tokens){
+    const CacheHeader *header = entry->header;
+    //interning the strings in id order into the empty pool gives them back
+    //their ids, unless the entry holds the same text twice
+    for(unsigned int i = 0; i < header->string_count; i++){
+        const char *text = entry->blob + entry->strings[i];
+        if(intern_string_id(&tokens->strings, text, strlen(text)) != (int)i){
+            clear_token_list(tokens);
+            return 0;
+        }
+    }
+
+    reserve_token_list(tokens, (int)header->token_count);
+    unsigned int text = 0;
+    for(unsigned int i = 0; i < header->token_count; i++){
+        TokenType type = (TokenType)entry->kinds[i];
+        int id = -1;
+        if(type > RELATIONAL_OP){
+            clear_token_list(tokens);
+            return 0;
+        }
+        if(token_has_text(type)){
+            if(text >= header->text_count || entry->texts[text] < 0
+               || (unsigned int)entry->texts[text] >= header->string_count){
+                clear_token_list(tokens);
+                return 0;
+            }
+            id = entry->texts[text++];
+        }
+        add_token(tokens, type, entry->offsets[i], id);
+    }
+    if(text != header->text_count){
+        clear_token_list(tokens);
+        return 0;
+    }
+    cached_line_map(entry, &tokens->lines);
+    return 1;
+}
+
+void cached_errors(const CacheEntry *entry, ErrorList *errors, int lexical_only){
+    for(unsigned int i = 0; i < entry->header->error_count; i++){
+        const CachedError *error = &entry->errors[i];
+        if(lexical_only && error->type != LEXICAL_ERR){
+            continue;
+        }
+        add_error(errors, create_error((ErrorType)error->type, entry->blob + error->message, error->offset));
+    }
+}
+
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Blob;
+
+//offset of a NUL terminated copy of text
+static unsigned int blob_add(Blob *blob, const char *text){
+    size_t size = strlen(text) + 1;
+    if(blob->length + size > blob->capacity){
+        while(blob->length + size > blob->capacity){
+            blob->capacity = blob->capacity == 0 ? 4096 : blob->capacity * 2;
+        }
+        blob->data = realloc(blob->data, blob->capacity);
+    }
+    memcpy(blob->data + blob->length, text, size);
+    blob->length += size;
+    return (unsigned int)(blob->length - size);
+}
+
+//places a section of size bytes at the end of the layout, 8 byte aligned
+static unsigned long long place_section(unsigned long long *end, size_t size){
+    unsigned long long offset = (*end + 7) & ~7ULL;
+    *end = offset + size;
+    return offset;
+}
+
+//the entry is put together in memory, padding zeroed, so the body can be
+//hashed before it is written
+static void copy_section(char *entry, unsigned int offset, const void *data, size_t size){
+    if(size > 0){
+        memcpy(entry + offset, data, size);
+    }
+}
+
+int store_cache_entry(const AnalysisCache *cache, unsigned long long hash, size_t length,
+                      const TokenList *tokens, const ErrorList *errors, int error_count){
+    if(length > UINT_MAX){
+        return 0;
+    }
+    if(error_count > errors->count){
+        error_count = errors->count;
+    }
+
+    Blob blob = {0};
+    const StringPool *pool = &tokens->strings;
+    unsigned int *strings = malloc(sizeof(unsigned int) * (size_t)(pool->count + 1));
+    for(int i = 0; i < pool->count; i++){
+        strings[i] = blob_add(&blob, string_pool_text(pool, i));
+    }
+    CachedError *cached_errors = malloc(sizeof(CachedError) * (size_t)(error_count + 1));
+    for(int i = 0; i < error_count; i++){
+        cached_errors[i].type = errors->errors[i].type;
+        cached_errors[i].offset = errors->errors[i].offset;
+        cached_errors[i].message = blob_add(&blob, errors->errors[i].err_message);
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.format = CACHE_FORMAT;
+    memcpy(header.identity, cache->identity, CACHE_IDENTITY_SIZE);
+    header.content_hash = hash;
+    header.content_length = length;
+    header.token_count = (unsigned int)tokens->count;
+    header.text_count = (unsigned int)tokens->text_count;
+    header.line_count = (unsigned int)tokens->lines.count;
+    header.string_count = (unsigned int)pool->count;
+    header.error_count = (unsigned int)error_count;
+    header.blob_size = (unsigned int)blob.length;
+
+    unsigned long long end = sizeof(CacheHeader);
+    unsigned long long kinds = place_section(&end, (size_t)tokens->count);
+    unsigned long long offsets = place_section(&end, sizeof(unsigned int) * (size_t)tokens->count);
+    unsigned long long texts = place_section(&end, sizeof(int) * (size_t)tokens->text_count);
+    unsigned long long lines = place_section(&end, sizeof(unsigned int) * (size_t)tokens->lines.count);
+    unsigned long long string_section = place_section(&end, sizeof(unsigned int) * (size_t)pool->count);
+    unsigned long long error_section = place_section(&end, sizeof(CachedError) * (size_t)error_count);
+    unsigned long long blob_section = place_section(&end, blob.length);
+
+    int stored = 0;
+    if(end <= UINT_MAX && blob.length <= UINT_MAX){
+        header.size = (unsigned int)end;
+        header.kinds = (unsigned int)kinds;
+        header.offsets = (unsigned int)offsets;
+        header.texts = (unsigned int)texts;
+        header.lines = (unsigned int)lines;
+        header.strings = (unsigned int)string_section;
+        header.errors = (unsigned int)error_section;
+        header.blob = (unsigned int)blob_section;
+
+        //written next to the entry and renamed over it; the name is unique
+        //to this process and call, so concurrent writers never share a file
+        static unsigned int serial;
+        char name[96];
+        snprintf(name, sizeof(name), "%016llx.frgc.%ld-%u.tmp", hash, (long)getpid(),
+                 __atomic_fetch_add(&serial, 1, __ATOMIC_RELAXED));
+        char *temporary = cache_path(cache, name);
+        char *path = entry_path(cache, hash);
+        char *data = calloc(1, (size_t)end);
+        copy_section(data, header.kinds, tokens->kinds, (size_t)tokens->count);
+        copy_section(data, header.offsets, tokens->offsets, sizeof(unsigned int) * (size_t)tokens->count);
+        copy_section(data, header.texts, tokens->texts, sizeof(int) * (size_t)tokens->text_count);
+        copy_section(data, header.lines, tokens->lines.starts, sizeof(unsigned int) * (size_t)tokens->lines.count);
+        copy_section(data, header.strings, strings, sizeof(unsigned int) * (size_t)pool->count);
+        copy_section(data, header.errors, cached_errors, sizeof(CachedError) * (size_t)error_count);
+        copy_section(data, header.blob, blob.data, blob.length);
+        header.body_hash = hash_content(data + sizeof(CacheHeader), (size_t)end - sizeof(CacheHeader));
+        memcpy(data, &header, sizeof(header));
+
+        FILE *f = fopen(temporary, "wb");
+        if(f != NULL){
+            stored = fwrite(data, 1, (size_t)end, f) == (size_t)end;
+            stored = fclose(f) == 0 && stored;
+#ifdef _WIN32
+            //rename does not replace an existing file here
+            if(stored){
+                remove(path);
+            }
+#endif
+            stored = stored && rename(temporary, path) == 0;
+            if(!stored){
+                remove(temporary);
+            }
+        }
+        free(data);
+        free(temporary);
+        free(path);
+    }
+
+    free(strings);
+    free(cached_errors);
+    free(blob.data);
+    return stored;
+}
+
+typedef struct {
+    char *name;
+    long long used;     //modification time in nanoseconds
+    unsigned long long size;
+} CacheFile;
+
+//entries touched within the same second still have to be told apart
+static long long modification_time(const struct stat *st){
+#ifdef _WIN32
+    return (long long)st->st_mtime * 1000000000LL;
+#else
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#endif
+}
+
+static int compare_cache_files(const void *a, const void *b){
+    const CacheFile *x = (const CacheFile *)a;
+    const CacheFile *y = (const CacheFile *)b;
+    if(x->used != y->used){
+        return x->used < y->used ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+static int is_cache_file(const char *name){
+    size_t length = strlen(name);
+    return (length > 5 && strcmp(name + length - 5, ".frgc") == 0)
+        || (length > 4 && strcmp(name + length - 4, ".tmp") == 0 && strstr(name, ".frgc.") != NULL);
+}
+
+void trim_cache(const AnalysisCache *cache){
+    DIR *dir = opendir(cache->directory);
+    if(dir == NULL){
+        return;
+    }
+
+    CacheFile *files = NULL;
+    int count = 0;
+    int capacity = 0;
+    unsigned long long total = 0;
+    struct dirent *item;
+    while((item = readdir(dir)) != NULL){
+        if(!is_cache_file(item->d_name)){
+            continue;
+        }
+        char *path = cache_path(cache, item->d_name);
+        struct stat st;
+        if(stat(path, &st) != 0 || !S_ISREG(st.st_mode)){
+            free(path);
+            continue;
+        }
+        if(count >= capacity){
+            capacity = capacity == 0 ? 64 : capacity * 2;
+            files = realloc(files, sizeof(CacheFile) * (size_t)capacity);
+        }
+        files[count].name = path;
+        files[count].used = modification_time(&st);
+        files[count].size = (unsigned long long)st.st_size;
+        total += files[count].size;
+        count++;
+    }
+    closedir(dir);
+
+    if(total > cache->limit){
+        qsort(files, (size_t)count, sizeof(CacheFile), compare_cache_files);
+        for(int i = 0; i < count && total > cache->limit; i++){
+            if(remove(files[i].name) == 0){
+                total -= files[i].size;
+            }
+        }
+    }
+    for(int i = 0; i < count; i++){
+        free(files[i].name);
+    }
+    free(files);
+}
@@ -0,0 +1,31 @@
+#include <string.h>
+#include "../include/context.h"
+
+void init_compilation_context(CompilationContext *context){
+    memset(context, 0, sizeof(*context));
+    init_ast(&context->ast);
+    init_optimization_report(&context->optimization);
+    init_chunk(&context->chunk);
+    init_output_buffer(&context->output);
+}
+
+void reset_compilation_context(CompilationContext *context, size_t source_length){
+    clear_token_list(&context->tokenList);
+    clear_error_list(&context->errorList);
+    clear_symbol_table(&context->symbolTable);
+    clear_ast(&context->ast);
+    clear_optimization_report(&context->optimization);
+    clear_chunk(&context->chunk);
+    clear_output_buffer(&context->output);
+    reserve_token_list(&context->tokenList, estimate_token_count(source_length));
+}
+
+void free_compilation_context(CompilationContext *context){
+    free_token_list(&context->tokenList);
+    free_error_list(&context->errorList);
+    free_symbol_table(&context->symbolTable);
+    free_ast(&context->ast);
+    free_optimization_report(&context->optimization);
+    free_chunk(&context->chunk);
+    free_output_buffer(&context->output);
+}
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/document.h"
+#include "../include/lexer.h"
+
+// Incremental front end for the editor: an edit re-lexes the replaced lines
+// (plus following lines while the carried lexer state differs), splices the
+// new tokens in place and re-parses from the statement before the change.
+
+void init_document(Document *doc){
+    memset(doc, 0, sizeof(*doc));
+    init_ast(&doc->analysis.ast);
+    init_optimization_report(&doc->analysis.optimization);
+    init_parse_log(&doc->parseLog);
+
+    doc->capacity = 64;
+    doc->text = malloc(doc->capacity);
+    doc->text[0] = '\0';
+    doc->line_capacity = 16;
+    doc->lines = calloc((size_t)doc->line_capacity, sizeof(LineInfo));
+    doc->line_count = 1;
+    doc->lines[0].end_type = NONE;
+}
+
+void free_document(Document *doc){
+    free(doc->text);
+    free(doc->lines);
+    free_error_list(&doc->lexErrors);
+    free_error_list(&doc->parseErrors);
+    free_parse_log(&doc->parseLog);
+    free_token_list(&doc->analysis.tokenList);
+    free_symbol_table(&doc->analysis.symbolTable);
+    free_ast(&doc->analysis.ast);
+    free_optimization_report(&doc->analysis.optimization);
+    free(doc->analysis.errorList.errors);
+    memset(doc, 0, sizeof(*doc));
+}
+
+void document_set_text(Document *doc, const char *text, size_t length){
+    int new_count = 1;
+    for(const char *p = text; (p = memchr(p, '\n', (size_t)(text + length - p))) != NULL; p++){
+        new_count++;
+    }
+    document_replace_lines(doc, 0, doc->line_count, new_count, text, length);
+}
+
+static void splice_text(Document *doc, size_t start, size_t old_length, const char *text, size_t length){
+    size_t new_length = doc->length - old_length + length;
+    if(new_length + 1 > doc->capacity){
+        while(new_length + 1 > doc->capacity){
+            doc->capacity *= 2;
+        }
+        doc->text = realloc(doc->text, doc->capacity);
+    }
+    memmove(doc->text + start + length, doc->text + start + old_length, doc->length - start - old_length);
+    memcpy(doc->text + start, text, length);
+    doc->length = new_length;
+    doc->text[new_length] = '\0';
+}
+
+static void splice_lines(Document *doc, int first, int old_count, int new_count){
+    int new_line_count = doc->line_count - old_count + new_count;
+    if(new_line_count > doc->line_capacity){
+        while(new_line_count > doc->line_capacity){
+            doc->line_capacity *= 2;
+        }
+        doc->lines = realloc(doc->lines, sizeof(LineInfo) * doc->line_capacity);
+    }
+    memmove(doc->lines + first + new_count, doc->lines + first + old_count,
+            sizeof(LineInfo) * (size_t)(doc->line_count - first - old_count));
+    memset(doc->lines + first, 0, sizeof(LineInfo) * (size_t)new_count);
+    doc->line_count = new_line_count;
+}
+
+//the removed messages stay in the list's arena until the next compaction
+static void rotate_errors(ErrorList *list, int at, int removed, int fresh_start){
+    if(list->count == 0){
+        return;
+    }
+    int fresh = list->count - fresh_start;
+    int suffix = fresh_start - at - removed;
+    Error *moved = malloc(sizeof(Error) * (size_t)(fresh > 0 ? fresh : 1));
+    memcpy(moved, list->errors + fresh_start, sizeof(Error) * (size_t)fresh);
+    memmove(list->errors + at + fresh, list->errors + at + removed, sizeof(Error) * (size_t)suffix);
+    memcpy(list->errors + at, moved, sizeof(Error) * (size_t)fresh);
+    list->count = at + fresh + suffix;
+    free(moved);
+}
+
+//index of the token in [first, first + count) that starts at offset, or -1
+static int find_token_at(const TokenList *tokens, int first, int count, unsigned int offset){
+    int low = first;
+    int high = first + count - 1;
+    while(low <= high){
+        int mid = (low + high) / 2;
+        if(tokens->offsets[mid] == offset){
+            return mid;
+        }
+        if(tokens->offsets[mid] < offset){
+            low = mid + 1;
+        }else{
+            high = mid - 1;
+        }
+    }
+    return -1;
+}
+
+//moves the parse errors along with their tokens after an edit that left the
+//tokens as they were except for their offsets; the old tokens of the edit
+//are still at first_token and their new copies at fresh_tokens. Errors at
+//the start of a line stay with the line. Returns 0, changing nothing, if an
+//error in the edit is at neither the start of a token nor that of the edit's
+//first line.
+static int follow_parse_errors(Document *doc, size_t start, size_t old_length, long long byte_delta,
+                               int first_token, int count, int fresh_tokens){
+    const TokenList *tokens = &doc->analysis.tokenList;
+    for(int apply = 0; apply < 2; apply++){
+        for(int i = 0; i < doc->parseErrors.count; i++){
+            Error *err = &doc->parseErrors.errors[i];
+            if(err->offset == NO_SOURCE_OFFSET || err->offset < start){
+                continue;
+            }
+            if(err->at_line_start && err->offset == start){
+                continue;
+            }
+            if(err->offset >= start + old_length){
+                if(apply){
+                    err->offset = (unsigned int)((long long)err->offset + byte_delta);
+                }
+                continue;
+            }
+            int token = err->at_line_start ? -1 : find_token_at(tokens, first_token, count, err->offset);
+            if(token < 0){
+                return 0;
+            }
+            if(apply){
+                err->offset = tokens->offsets[fresh_tokens + token - first_token];
+            }
+        }
+    }
+    return 1;
+}
+
+static void refresh_error_view(Document *doc){
+    ErrorList *view = &doc->analysis.errorList;
+    int count = doc->lexErrors.count + doc->parseErrors.count;
+    if(count > doc->error_view_capacity){
+        doc->error_view_capacity = count * 2;
+        view->errors = realloc(view->errors, sizeof(Error) * (size_t)doc->error_view_capacity);
+    }
+    if(doc->lexErrors.count > 0){
+        memcpy(view->errors, doc->lexErrors.errors, sizeof(Error) * (size_t)doc->lexErrors.count);
+    }
+    if(doc->parseErrors.count > 0){
+        memcpy(view->errors + doc->lexErrors.count, doc->parseErrors.errors, sizeof(Error) * (size_t)doc->parseErrors.count);
+    }
+    view->count = count;
+    view->capacity = doc->error_view_capacity;
+}
+
+//Replaces old_count lines starting at first_line with new_count lines taken
+//from text, which must hold exactly those lines (each ending in '\n' except
+//the document's last line).
+void document_replace_lines(Document *doc, int first_line, int old_count, int new_count,
+                            const char *text, size_t length){
+    if(first_line < 0 || first_line >= doc->line_count || new_count < 1){
+        return;
+    }
+    if(old_count > doc->line_count - first_line){
+        old_count = doc->line_count - first_line;
+    }
+
+    TokenList *tokens = &doc->analysis.tokenList;
+    size_t start = 0;
+    int first_token = 0;
+    int first_error = 0;
+    for(int i = 0; i < first_line; i++){
+        start += doc->lines[i].length;
+        first_token += doc->lines[i].token_count;
+        first_error += doc->lines[i].error_count;
+    }
+
+    size_t old_length = 0;
+    int removed_tokens = 0;
+    int removed_errors = 0;
+    for(int i = first_line; i < first_line + old_count; i++){
+        old_length += doc->lines[i].length;
+        removed_tokens += doc->lines[i].token_count;
+        removed_errors += doc->lines[i].error_count;
+    }
+
+    //lexer state the first untouched line was lexed with
+    TokenType state = first_line > 0 ? doc->lines[first_line - 1].end_type : NONE;
+    TokenType old_state = old_count > 0 ? doc->lines[first_line + old_count - 1].end_type : state;
+
+    splice_text(doc, start, old_length, text, length);
+    splice_lines(doc, first_line, old_count, new_count);
+    const char *piece = text;
+    for(int i = 0; i < new_count; i++){
+        const char *newline = i < new_count - 1 ? memchr(piece, '\n', (size_t)(text + length - piece)) : NULL;
+        const char *piece_end = newline ? newline + 1 : text + length;
+        doc->lines[first_line + i].length = (size_t)(piece_end - piece);
+        piece = piece_end;
+    }
+
+    //new tokens and errors are appended after the current ones, then rotated
+    //into place
+    int fresh_tokens = tokens->count;
+    int fresh_errors = doc->lexErrors.count;
+    size_t offset = start;
+    int line = first_line;
+    while(line < doc->line_count){
+        LineInfo *info = &doc->lines[line];
+        if(line >= first_line + new_count){
+            if(state == old_state){
+                break;
+            }
+            old_state = info->end_type;
+            removed_tokens += info->token_count;
+            removed_errors += info->error_count;
+        }
+
+        int token_count = tokens->count;
+        int error_count = doc->lexErrors.count;
+        lex_line(doc->text, offset, info->length, &state, tokens, &doc->lexErrors);
+        info->token_count = tokens->count - token_count;
+        info->error_count = doc->lexErrors.count - error_count;
+        info->end_type = state;
+
+        offset += info->length;
+        line++;
+    }
+    int relexed_tokens = tokens->count - fresh_tokens;
+    int relexed_errors = doc->lexErrors.count - fresh_errors;
+
+    //the parse only has to restart where the token stream really differs,
+    //down to the offsets the parse errors point at; if only offsets differ,
+    //the errors are moved instead. The line map is only rebuilt below, so the
+    //new tokens' lines come from the per-line counts.
+    int unchanged = 0;
+    int same_shape = 0;
+    int fresh_line = first_line;
+    int line_left = doc->lines[first_line].token_count;
+    int line_hint = 0;
+    while(same_shape < relexed_tokens && same_shape < removed_tokens){
+        while(line_left == 0){
+            line_left = doc->lines[++fresh_line].token_count;
+        }
+        int before = first_token + same_shape;
+        int after = fresh_tokens + same_shape;
+        if(token_kind(tokens, before) != token_kind(tokens, after)
+           || token_text(tokens, before) != token_text(tokens, after)
+           || token_line(tokens, before, &line_hint) != fresh_line + 1){
+            break;
+        }
+        if(unchanged == same_shape && tokens->offsets[before] == tokens->offsets[after]){
+            unchanged++;
+        }
+        line_left--;
+        same_shape++;
+    }
+
+    int line_delta = new_count - old_count;
+    long long byte_delta = (long long)length - (long long)old_length;
+    int reparse = same_shape != relexed_tokens || same_shape != removed_tokens
+                  || line_delta != 0 || doc->analysis.ast.root < 0
+                  || !follow_parse_errors(doc, start, old_length, byte_delta, first_token, removed_tokens, fresh_tokens);
+
+    rotate_tokens(tokens, first_token, removed_tokens, fresh_tokens);
+    rotate_errors(&doc->lexErrors, first_error, removed_errors, fresh_errors);
+    doc->lex_messages += relexed_errors;
+    if(doc->lex_messages > 2 * doc->lexErrors.count + 64){
+        compact_error_list(&doc->lexErrors);
+        doc->lex_messages = doc->lexErrors.count;
+    }
+
+    //everything after the re-lexed lines only moved
+    if(line_delta != 0 || byte_delta != 0){
+        for(int i = first_token + relexed_tokens; i < tokens->count; i++){
+            tokens->offsets[i] = (unsigned int)((long long)tokens->offsets[i] + byte_delta);
+        }
+        for(int i = first_error + relexed_errors; i < doc->lexErrors.count; i++){
+            doc->lexErrors.errors[i].offset = (unsigned int)((long long)doc->lexErrors.errors[i].offset + byte_delta);
+        }
+    }
+
+    clear_line_map(&tokens->lines);
+    size_t line_start = 0;
+    for(int i = 0; i < doc->line_count; i++){
+        add_line_start(&tokens->lines, (unsigned int)line_start);
+        line_start += doc->lines[i].length;
+    }
+
+    if(reparse){
+        Parser parser;
+        init_parser(&parser, tokens, &doc->analysis.symbolTable, &doc->parseErrors, &doc->analysis.ast);
+        TokenEdit edit;
+        edit.first = first_token + unchanged;
+        edit.end = first_token + relexed_tokens;
+        edit.delta = relexed_tokens - removed_tokens;
+        edit.lines_moved = line_delta != 0;
+        edit.text_end = (unsigned int)(start + old_length);
+        edit.text_delta = (int)byte_delta;
+        parse_incremental(&parser, &doc->parseLog, &edit);
+    }
+    refresh_error_view(doc);
+    doc->analysis.content_length = doc->length;
+}
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../include/interpreter.h"
+
+// Tree-walking interpreter over the AST built by parse(). Variables are read
+// and written directly in the SymbolTable's typed values.
+
+typedef struct {
+    const Ast *ast;
+    SymbolTable *symbolTable;
+    ErrorList *errors;
+    const LineMap *lines;   //where the lines of the AST start in the source
+    OutputBuffer *output;
+    int halted;
+} Interpreter;
+
+static void runtime_error(Interpreter *interp, const char *message, int line){
+    Error err = create_error(SEMANTIC_ERR, message, line_start_offset(interp->lines, line));
+    add_error(interp->errors, err);
+    interp->halted = 1;
+}
+
+static Value evaluate(Interpreter *interp, int index){
+    if(index < 0 || interp->halted){
+        return undefined_value();
+    }
+
+    const AstNode *node = &interp->ast->nodes[index];
+    switch(node->kind){
+        case AST_INT_LITERAL:
+            return int_value(node->literal.integer);
+        case AST_REAL_LITERAL:
+            return real_value(node->literal.number);
+        case AST_STRING_LITERAL:
+            return string_value(node->literal.text);
+        case AST_VARIABLE:
+            if(node->symbol >= 0){
+                return interp->symbolTable->symbols[node->symbol].value;
+            }
+            break;
+        case AST_NEGATE: {
+            Value operand = evaluate(interp, node->left);
+            if(operand.type == KEY_INT){
+                if(operand.as.i == LLONG_MIN){
+                    runtime_error(interp, "Integer overflow", node->line);
+                    break;
+                }
+                return int_value(-operand.as.i);
+            }
+            if(operand.type == KEY_REAL){
+                return real_value(-operand.as.r);
+            }
+            break;
+        }
+        case AST_BINARY: {
+            Value lhs = evaluate(interp, node->left);
+            Value rhs = evaluate(interp, node->right);
+            if(!value_is_number(&lhs) || !value_is_number(&rhs)){
+                break;
+            }
+
+            if(node->op == OPERATOR_DIVIDE){
+                double r = value_as_real(&rhs);
+                if(r == 0.0){
+                    runtime_error(interp, "Division by zero", node->line);
+                    break;
+                }
+                return real_value(value_as_real(&lhs) / r);
+            }
+
+            if(lhs.type == KEY_INT && rhs.type == KEY_INT){
+                long long result;
+                int overflow;
+                switch(node->op){
+                    case OPERATOR_PLUS: overflow = __builtin_add_overflow(lhs.as.i, rhs.as.i, &result); break;
+                    case OPERATOR_MINUS: overflow = __builtin_sub_overflow(lhs.as.i, rhs.as.i, &result); break;
+                    default: overflow = __builtin_mul_overflow(lhs.as.i, rhs.as.i, &result); break;
+                }
+                if(overflow){
+                    runtime_error(interp, "Integer overflow", node->line);
+                    break;
+                }
+                return int_value(result);
+            }
+
+            double l = value_as_real(&lhs);
+            double r = value_as_real(&rhs);
+            switch(node->op){
+                case OPERATOR_PLUS: return real_value(l + r);
+                case OPERATOR_MINUS: return real_value(l - r);
+                default: return real_value(l * r);
+            }
+        }
+        default:
+            break;
+    }
+    return undefined_value();
+}
+
+//1 if the condition holds, 0 if not, -1 when it cannot be evaluated
+static int evaluate_condition(Interpreter *interp, int index){
+    if(index < 0){
+        return -1;
+    }
+
+    const AstNode *node = &interp->ast->nodes[index];
+    Value lhs = evaluate(interp, node->left);
+    Value rhs = evaluate(interp, node->right);
+    int cmp;
+    if(!compare_values(&lhs, &rhs, &cmp)){
+        return -1;
+    }
+
+    switch(node->op){
+        case REL_LT: return cmp < 0;
+        case REL_LE: return cmp <= 0;
+        case REL_GT: return cmp > 0;
+        case REL_GE: return cmp >= 0;
+        case REL_NE: return cmp != 0;
+        default: return cmp == 0;
+    }
+}
+
+static void append_value(Interpreter *interp, Value value, int is_first){
+    if(interp->output == NULL){
+        return;
+    }
+    if(!is_first){
+        output_buffer_append(interp->output, " ");
+    }
+
+    char buffer[64];
+    const char *text = format_value(&value, buffer, sizeof(buffer));
+    output_buffer_append(interp->output, text ? text : "<undef>");
+}
+
+static void execute(Interpreter *interp, int index);
+
+static void execute_children(Interpreter *interp, const AstNode *node){
+    for(int i = 0; i < node->child_count && !interp->halted; i++){
+        execute(interp, interp->ast->children[node->first_child + i]);
+    }
+}
+
+static void execute(Interpreter *interp, int index){
+    if(index < 0 || interp->halted){
+        return;
+    }
+
+    const AstNode *node = &interp->ast->nodes[index];
+    switch(node->kind){
+        case AST_PROGRAM:
+        case AST_BLOCK:
+        case AST_DECLARATION:
+            execute_children(interp, node);
+            break;
+        case AST_ASSIGN: {
+            Value value = evaluate(interp, node->left);
+            if(node->symbol >= 0){
+                Symbol *sym = &interp->symbolTable->symbols[node->symbol];
+                if(sym->type == KEY_REAL && value.type == KEY_INT){
+                    value = real_value((double)value.as.i);
+                }
+                sym->value = value;
+            }
+            break;
+        }
+        case AST_PRINT:
+            for(int i = 0; i < node->child_count; i++){
+                append_value(interp, evaluate(interp, interp->ast->children[node->first_child + i]), i == 0);
+            }
+            if(node->child_count > 0 && interp->output != NULL){
+                output_buffer_append(interp->output, "\n");
+            }
+            break;
+        case AST_IF: {
+            int holds = evaluate_condition(interp, node->left);
+            if(holds == 1){
+                execute(interp, node->right);
+            } else if(holds == 0){
+                execute(interp, node->extra);
+            }
+            break;
+        }
+        case AST_REPEAT: {
+            long iterations = 0;
+            while(!interp->halted){
+                execute_children(interp, node);
+                if(evaluate_condition(interp, node->left) != 0){
+                    break;
+                }
+                if(++iterations >= MAX_REPEAT_ITERATIONS){
+                    char msg[128];
+                    snprintf(msg, sizeof(msg), "Repeat loop did not reach its until condition after %d iterations", MAX_REPEAT_ITERATIONS);
+                    runtime_error(interp, msg, node->line);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void execute_program(const Ast *ast, SymbolTable *symbolTable, ErrorList *errors, const LineMap *lines, OutputBuffer *output){
+    if(ast == NULL || ast->root < 0){
+        return;
+    }
+
+    Interpreter interp;
+    interp.ast = ast;
+    interp.symbolTable = symbolTable;
+    interp.errors = errors;
+    interp.lines = lines;
+    interp.output = output;
+    interp.halted = 0;
+    for(int i = 0; i < symbolTable->count; i++){
+        symbolTable->symbols[i].value = undefined_value();
+    }
+
+    execute(&interp, ast->root);
+}
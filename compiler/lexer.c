@@ -2,270 +2,456 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "../include/token.h"
 #include "../include/error.h"
 #include "../include/lexer.h"
+#include "../include/source.h"
+#include "../include/scan.h"
 
-static int equals_ignore_case(const char *a, const char *b) {
-    while(*a && *b) {
-        if(tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+static int equals_ignore_case(const char *a, size_t len, const char *b) {
+    size_t i = 0;
+    while(i < len && *b) {
+        if(tolower((unsigned char)a[i]) != tolower((unsigned char)*b)) {
             return 0;
         }
-        a++;
+        i++;
         b++;
     }
-    return *a == '\0' && *b == '\0';
+    return i == len && *b == '\0';
 }
 
-static void emit_token(TokenList *tokenList, TokenType type, const char *lexeme, int line, TokenType *last_type) {
-    Token token = create_token(type, lexeme, line);
-    add_token(tokenList, token);
+// Case-insensitive keyword lookup: dispatch on length and one distinguishing
+// character, so each word is compared against at most one keyword.
+TokenType keyword_type(const char *word, size_t length) {
+    const char *candidate = NULL;
+    TokenType type = IDENTIFIER;
+
+    switch(length) {
+        case 2:
+            candidate = "If"; type = KEYWORD_IF;
+            break;
+        case 3:
+            candidate = "End"; type = BLOCK_END;
+            break;
+        case 4:
+            candidate = "Else"; type = KEYWORD_ELSE;
+            break;
+        case 5:
+            switch(word[0] | 0x20) {
+                case 'u': candidate = "Until"; type = KEYWORD_UNTIL; break;
+                case 'b': candidate = "Begin"; type = BLOCK_BEGIN; break;
+            }
+            break;
+        case 6:
+            candidate = "Repeat"; type = KEYWORD_REPEAT;
+            break;
+        case 7:
+            switch(word[4] | 0x20) {
+                case 'e': candidate = "FRG_End"; type = KEYWORD_END; break;
+                case 'i': candidate = "FRG_Int"; type = KEYWORD_INT; break;
+            }
+            break;
+        case 8:
+            switch(word[4] | 0x20) {
+                case 'r': candidate = "FRG_Real"; type = KEYWORD_REAL; break;
+                case 's': candidate = "FRG_Strg"; type = KEYWORD_STRING; break;
+            }
+            break;
+        case 9:
+            switch(word[4] | 0x20) {
+                case 'b': candidate = "FRG_Begin"; type = KEYWORD_BEGIN; break;
+                case 'p': candidate = "FRG_Print"; type = KEYWORD_PRINT; break;
+            }
+            break;
+    }
+
+    if(candidate != NULL && equals_ignore_case(word, length, candidate)) {
+        return type;
+    }
+    return IDENTIFIER;
+}
+
+static const char *relational_spelling(const char *lexeme, size_t length) {
+    static const char *const spellings[] = {"<", "<=", ">", ">=", "=", "==", "!="};
+    for(size_t i = 0; i < sizeof(spellings) / sizeof(spellings[0]); i++) {
+        if(strlen(spellings[i]) == length && memcmp(spellings[i], lexeme, length) == 0) {
+            return spellings[i];
+        }
+    }
+    return "";
+}
+
+// The token records where its lexeme starts; only identifiers, literals,
+// comments and relations get text, interned once in the list's pool.
+static void emit_token(TokenList *tokenList, TokenType type, const char *data, const char *lexeme, size_t length, TokenType *last_type) {
+    int text = -1;
+    switch(type) {
+        case IDENTIFIER:
+        case INTEGER_LITERAL:
+        case FLOAT_LITERAL:
+        case COMMENT:
+            text = intern_string_id(&tokenList->strings, lexeme, length);
+            break;
+        case STRING_LITERAL:
+            text = intern_string_id(&tokenList->strings, lexeme + 1, length - 2);
+            break;
+        case RELATIONAL_OP: {
+            const char *spelling = relational_spelling(lexeme, length);
+            text = intern_string_id(&tokenList->strings, spelling, strlen(spelling));
+            break;
+        }
+        default:
+            break;
+    }
+
+    add_token(tokenList, type, (unsigned int)(lexeme - data), text);
     if(last_type != NULL) {
         *last_type = type;
     }
 }
 
-static int is_comment_line(const char *line) {
-    int idx = 0;
-    while(line[idx] != '\0' && (line[idx] == ' ' || line[idx] == '\t')) {
+static int is_comment_line(const char *line, size_t len) {
+    size_t idx = 0;
+    while(idx < len && (line[idx] == ' ' || line[idx] == '\t')) {
         idx++;
     }
 
-    if(line[idx] == '#' && line[idx + 1] == '#') {
+    if(idx + 1 < len && line[idx] == '#' && line[idx + 1] == '#') {
         return 1;
     }
     return 0;
 }
 
-void lexer(char *filePath, TokenList *tokenList, ErrorList *errorList){
-    FILE *f = fopen(filePath, "r");
-    if(f == NULL){
-        printf("Error: Cannot open file %s\n", filePath);
+//returns 0 if the file cannot be read; reporting that is up to the caller
+int lexer(char *filePath, TokenList *tokenList, ErrorList *errorList){
+    SourceFile source;
+    if(!load_source_file(filePath, &source)){
+        return 0;
+    }
+
+    lex_source(&source, tokenList, errorList);
+    free_source_file(&source);
+    return 1;
+}
+
+//lexes a file already loaded, or any source kept in memory
+void lex_source(const SourceFile *source, TokenList *tokenList, ErrorList *errorList){
+    lex_buffer(source->data, source->length, tokenList, errorList);
+}
+
+//lexes the lines in data[start, end), adding where each one starts to the
+//list's line map; the newlines are found by scan_find, 16 or 32 bytes at a time
+static void lex_range(const char *data, size_t start, size_t end, TokenType *last_type, TokenList *tokenList, ErrorList *errorList){
+    const char *cursor = data + start;
+    const char *data_end = data + end;
+
+    while(cursor < data_end){
+        const char *newline = scan_find(cursor, (size_t)(data_end - cursor), '\n');
+        const char *line_end = newline ? newline : data_end;
+        size_t offset = (size_t)(cursor - data);
+        cursor = newline ? newline + 1 : data_end;
+
+        add_line_start(&tokenList->lines, (unsigned int)offset);
+        lex_line(data, offset, (size_t)(line_end - data) - offset, last_type, tokenList, errorList);
+    }
+}
+
+// Lexes directly out of the caller's buffer: no per-line copy and no line length limit.
+void lex_buffer(const char *data, size_t length, TokenList *tokenList, ErrorList *errorList){
+    if(length > MAX_SOURCE_LENGTH){
+        add_error(errorList, create_error(LEXICAL_ERR, "Source is 4 GB or larger, which is not supported", NO_SOURCE_OFFSET));
         return;
     }
-    
-    char line[512];
-    int line_number = 1;
     TokenType last_type = NONE;
-    
-    while(fgets(line, sizeof(line), f) != NULL){
-        int len = strlen(line);
-        while(len > 0 && (line[len-1] == '\n' || line[len-1] == '\r')){
-            line[--len] = '\0';
+    lex_range(data, 0, length, &last_type, tokenList, errorList);
+}
+
+// Smallest piece worth a thread of its own
+#ifndef PARALLEL_LEX_MIN_CHUNK
+#define PARALLEL_LEX_MIN_CHUNK (1 << 20)
+#endif
+
+//one line aligned piece of the input, lexed as if it started the file
+typedef struct {
+    const char *data;
+    size_t start;
+    size_t end;
+    TokenList tokens;
+    ErrorList errors;
+    TokenType last_type;
+    int skip;   //filled in before the pieces are joined
+} LexChunk;
+
+static void *lex_chunk(void *arg){
+    LexChunk *chunk = (LexChunk *)arg;
+    chunk->last_type = NONE;
+    lex_range(chunk->data, chunk->start, chunk->end, &chunk->last_type, &chunk->tokens, &chunk->errors);
+    return NULL;
+}
+
+//runs work on every chunk, the first one on the calling thread, and so any
+//other whose thread could not be started
+static void run_chunks(LexChunk *chunks, int count, void *(*work)(void *)){
+    pthread_t *threads = malloc(sizeof(pthread_t) * (size_t)count);
+    int *started = calloc((size_t)count, sizeof(int));
+    for(int i = 1; i < count; i++){
+        started[i] = pthread_create(&threads[i], NULL, work, &chunks[i]) == 0;
+    }
+    work(&chunks[0]);
+    for(int i = 1; i < count; i++){
+        if(started[i]){
+            pthread_join(threads[i], NULL);
+        }else{
+            work(&chunks[i]);
         }
+    }
+    free(started);
+    free(threads);
+}
 
-        if(len == 0){
-            line_number++;
-            continue;
+// Same result as lex_buffer, with the input split at line boundaries and the
+// pieces lexed on up to `threads` threads. The only state crossing a line is
+// the last token type, and it only matters for '#' right after FRG_Begin:
+// each piece is lexed as if it followed nothing, and when the piece before
+// it actually ended on FRG_Begin its leading '#' tokens are dropped, exactly
+// what the sequential lexer would have suppressed.
+void lex_buffer_parallel(const char *data, size_t length, int threads, TokenList *tokenList, ErrorList *errorList){
+    int count = threads;
+    if((size_t)count > length / PARALLEL_LEX_MIN_CHUNK){
+        count = (int)(length / PARALLEL_LEX_MIN_CHUNK);
+    }
+    if(count <= 1 || length > MAX_SOURCE_LENGTH){
+        lex_buffer(data, length, tokenList, errorList);
+        return;
+    }
+
+    LexChunk *chunks = calloc((size_t)count, sizeof(LexChunk));
+    size_t start = 0;
+    int used = 0;
+    for(int i = 0; i < count && start < length; i++){
+        size_t end = length;
+        if(i < count - 1){
+            size_t target = (size_t)((unsigned long long)length * (unsigned long long)(i + 1) / (unsigned long long)count);
+            if(target < start){
+                target = start;
+            }
+            const char *newline = memchr(data + target, '\n', length - target);
+            end = newline ? (size_t)(newline - data) + 1 : length;
+        }
+        chunks[used].data = data;
+        chunks[used].start = start;
+        chunks[used].end = end;
+        used++;
+        start = end;
+    }
+    run_chunks(chunks, used, lex_chunk);
+
+    //carry the real lexer state from piece to piece; the tokens are then
+    //moved over in order, which is mostly memcpy. Offsets, and so the line
+    //map and the errors, are already relative to the whole buffer.
+    TokenType state = NONE;
+    int total = 0;
+    for(int i = 0; i < used; i++){
+        LexChunk *chunk = &chunks[i];
+        chunk->skip = 0;
+        if(state == KEYWORD_BEGIN){
+            while(chunk->skip < chunk->tokens.count && token_kind(&chunk->tokens, chunk->skip) == END_INSTRUCTION){
+                chunk->skip++;
+            }
+        }
+        if(chunk->skip < chunk->tokens.count){
+            state = chunk->last_type;
         }
+        total += chunk->tokens.count - chunk->skip;
+    }
 
-        if(is_comment_line(line)){
-            // Store the comment text starting at the first '#'
-            const char *comment_start = strchr(line, '#');
-            emit_token(tokenList, COMMENT, comment_start ? comment_start : line, line_number, &last_type);
-            line_number++;
-            continue;
+    reserve_token_list(tokenList, tokenList->count + total);
+    for(int i = 0; i < used; i++){
+        LexChunk *chunk = &chunks[i];
+        append_tokens(tokenList, &chunk->tokens, chunk->skip);
+        for(int j = 0; j < chunk->errors.count; j++){
+            add_error(errorList, chunk->errors.errors[j]);
         }
+        free_error_list(&chunk->errors);
+        free_token_list(&chunk->tokens);
+    }
+    free(chunks);
+}
 
-        int i = 0;
-        while(i < len){
-            char c = line[i];
+// Lexes one line (without its '\n') that starts at data + offset. The only
+// state carried between lines is the type of the last token emitted.
+void lex_line(const char *data, size_t offset, size_t length, TokenType *last_type_io, TokenList *tokenList, ErrorList *errorList){
+    const char *line = data + offset;
+    size_t len = length;
+    while(len > 0 && (line[len-1] == '\n' || line[len-1] == '\r')){
+        len--;
+    }
 
-            if(c == ' ' || c == '\t'){
-                i++;
-                continue;
-            }
+    if(len == 0){
+        return;
+    }
 
-            if(isalpha((unsigned char)c) || c == '_'){
-                char buffer[256] = {0};
-                int j = 0;
+    TokenType last_type = *last_type_io;
+    if(is_comment_line(line, len)){
+        // Store the comment text starting at the first '#'
+        const char *comment_start = memchr(line, '#', len);
+        emit_token(tokenList, COMMENT, data, comment_start, (size_t)(line + len - comment_start), &last_type);
+        *last_type_io = last_type;
+        return;
+    }
 
-                while(i < len && (isalnum((unsigned char)line[i]) || line[i] == '_')){
-                    if(j < (int)sizeof(buffer) - 1){
-                        buffer[j++] = line[i];
-                    }
-                    i++;
-                }
-                buffer[j] = '\0';
-
-                if(equals_ignore_case(buffer, "FRG_Begin")){
-                    emit_token(tokenList, KEYWORD_BEGIN, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "FRG_End")){
-                    emit_token(tokenList, KEYWORD_END, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "FRG_Int")){
-                    emit_token(tokenList, KEYWORD_INT, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "FRG_Real")){
-                    emit_token(tokenList, KEYWORD_REAL, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "FRG_Strg")){
-                    emit_token(tokenList, KEYWORD_STRING, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "FRG_Print")){
-                    emit_token(tokenList, KEYWORD_PRINT, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "If")){
-                    emit_token(tokenList, KEYWORD_IF, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "Else")){
-                    emit_token(tokenList, KEYWORD_ELSE, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "Repeat")){
-                    emit_token(tokenList, KEYWORD_REPEAT, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "Until")){
-                    emit_token(tokenList, KEYWORD_UNTIL, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "Begin")){
-                    emit_token(tokenList, BLOCK_BEGIN, buffer, line_number, &last_type);
-                } else if(equals_ignore_case(buffer, "End")){
-                    emit_token(tokenList, BLOCK_END, buffer, line_number, &last_type);
-                } else {
-                    emit_token(tokenList, IDENTIFIER, buffer, line_number, &last_type);
-                }
-                continue;
-            }
+    size_t i = 0;
+    while(i < len){
+        char c = line[i];
 
-            if(isdigit((unsigned char)c)){
-                char buffer[256] = {0};
-                int j = 0;
-                int has_dot = 0;
-
-                while(i < len && (isdigit((unsigned char)line[i]) || line[i] == '.')){
-                    if(line[i] == '.'){
-                        if(has_dot){
-                            Error err = create_error(LEXICAL_ERR, "Multiple decimal points in number", line_number);
-                            add_error(errorList, err);
-                            break;
-                        }
-                        has_dot = 1;
-                    }
-                    if(j < (int)sizeof(buffer) - 1){
-                        buffer[j++] = line[i];
-                    }
-                    i++;
-                }
-                buffer[j] = '\0';
+        if(scan_is(c, SCAN_BLANK)){
+            i += scan_blanks(line + i, len - i);
+            continue;
+        }
 
-                if(has_dot){
-                    emit_token(tokenList, FLOAT_LITERAL, buffer, line_number, &last_type);
-                } else {
-                    emit_token(tokenList, INTEGER_LITERAL, buffer, line_number, &last_type);
-                }
-                continue;
-            }
+        if(scan_is(c, SCAN_ALPHA)){
+            size_t start = i;
+            i += scan_identifier(line + i, len - i);
+            const char *word = line + start;
+            size_t word_len = i - start;
 
-            if(c == '"'){
-                char buffer[512] = {0};
-                int j = 0;
-                i++;
-                while(i < len && line[i] != '"'){
-                    if(j < (int)sizeof(buffer) - 1){
-                        buffer[j++] = line[i];
-                    }
-                    i++;
-                }
+            emit_token(tokenList, keyword_type(word, word_len), data, word, word_len, &last_type);
+            continue;
+        }
+
+        if(scan_is(c, SCAN_DIGIT)){
+            size_t start = i;
+            int has_dot = 0;
 
-                if(i >= len || line[i] != '"'){
-                    Error err = create_error(LEXICAL_ERR, "Unterminated string literal", line_number);
+            i += scan_digits(line + i, len - i);
+            while(i < len && line[i] == '.'){
+                if(has_dot){
+                    Error err = create_error(LEXICAL_ERR, "Multiple decimal points in number", (unsigned int)(line + i - data));
                     add_error(errorList, err);
-                } else {
-                    i++; // skip closing quote
-                    emit_token(tokenList, STRING_LITERAL, buffer, line_number, &last_type);
+                    break;
                 }
-                continue;
+                has_dot = 1;
+                i++;
+                i += scan_digits(line + i, len - i);
             }
 
-            if(c == ':' && i + 1 < len && line[i + 1] == '='){
-                emit_token(tokenList, ASSIGN_OP, ":=", line_number, &last_type);
-                i += 2;
-                continue;
+            if(has_dot){
+                emit_token(tokenList, FLOAT_LITERAL, data, line + start, i - start, &last_type);
+            } else {
+                emit_token(tokenList, INTEGER_LITERAL, data, line + start, i - start, &last_type);
             }
+            continue;
+        }
 
-            if(c == ','){
-                emit_token(tokenList, COMMA, ",", line_number, &last_type);
-                i++;
-                continue;
+        if(c == '"'){
+            size_t start = i;
+            i++;
+            const char *quote = scan_find(line + i, len - i, '"');
+            i = quote ? (size_t)(quote - line) : len;
+
+            if(i >= len){
+                Error err = create_error(LEXICAL_ERR, "Unterminated string literal", (unsigned int)(line + start - data));
+                add_error(errorList, err);
+            } else {
+                i++; // skip closing quote
+                emit_token(tokenList, STRING_LITERAL, data, line + start, i - start, &last_type);
             }
+            continue;
+        }
 
-            if(c == '['){
-                emit_token(tokenList, OPEN_BRACKET, "[", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == ':' && i + 1 < len && line[i + 1] == '='){
+            emit_token(tokenList, ASSIGN_OP, data, line + i, 2, &last_type);
+            i += 2;
+            continue;
+        }
 
-            if(c == ']'){
-                emit_token(tokenList, CLOSE_BRACKET, "]", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == ','){
+            emit_token(tokenList, COMMA, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '('){
-                emit_token(tokenList, OPEN_PAREN, "(", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == '['){
+            emit_token(tokenList, OPEN_BRACKET, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == ')'){
-                emit_token(tokenList, CLOSE_PAREN, ")", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == ']'){
+            emit_token(tokenList, CLOSE_BRACKET, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '+'){
-                emit_token(tokenList, OPERATOR_PLUS, "+", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == '('){
+            emit_token(tokenList, OPEN_PAREN, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '-'){
-                emit_token(tokenList, OPERATOR_MINUS, "-", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == ')'){
+            emit_token(tokenList, CLOSE_PAREN, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '*'){
-                emit_token(tokenList, OPERATOR_MULTIPLY, "*", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == '+'){
+            emit_token(tokenList, OPERATOR_PLUS, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '/'){
-                emit_token(tokenList, OPERATOR_DIVIDE, "/", line_number, &last_type);
-                i++;
-                continue;
-            }
+        if(c == '-'){
+            emit_token(tokenList, OPERATOR_MINUS, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '<' || c == '>' || c == '=' || c == '!'){
-                char op[3] = {c, '\0', '\0'};
-                if(i + 1 < len && line[i + 1] == '='){
-                    op[1] = '=';
-                    op[2] = '\0';
-                    i += 2;
-                } else {
-                    if(c == '!'){
-                        char msg[128];
-                        sprintf(msg, "Unknown operator '!'");
-                        Error err = create_error(LEXICAL_ERR, msg, line_number);
-                        add_error(errorList, err);
-                        i++;
-                        continue;
-                    }
-                    i++;
-                }
-                emit_token(tokenList, RELATIONAL_OP, op, line_number, &last_type);
-                continue;
-            }
+        if(c == '*'){
+            emit_token(tokenList, OPERATOR_MULTIPLY, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
+
+        if(c == '/'){
+            emit_token(tokenList, OPERATOR_DIVIDE, data, line + i, 1, &last_type);
+            i++;
+            continue;
+        }
 
-            if(c == '#'){
-                if(last_type != KEYWORD_BEGIN){
-                    emit_token(tokenList, END_INSTRUCTION, "#", line_number, &last_type);
+        if(c == '<' || c == '>' || c == '=' || c == '!'){
+            size_t start = i;
+            if(i + 1 < len && line[i + 1] == '='){
+                i += 2;
+            } else {
+                if(c == '!'){
+                    char msg[128];
+                    snprintf(msg, sizeof(msg), "Unknown operator '!'");
+                    Error err = create_error(LEXICAL_ERR, msg, (unsigned int)(line + i - data));
+                    add_error(errorList, err);
+                    i++;
+                    continue;
                 }
                 i++;
-                continue;
             }
+            emit_token(tokenList, RELATIONAL_OP, data, line + start, i - start, &last_type);
+            continue;
+        }
 
-            char error_msg[256];
-            sprintf(error_msg, "Unknown character '%c'", c);
-            Error err = create_error(LEXICAL_ERR, error_msg, line_number);
-            add_error(errorList, err);
+        if(c == '#'){
+            if(last_type != KEYWORD_BEGIN){
+                emit_token(tokenList, END_INSTRUCTION, data, line + i, 1, &last_type);
+            }
             i++;
+            continue;
         }
 
-        line_number++;
+        char error_msg[256];
+        snprintf(error_msg, sizeof(error_msg), "Unknown character '%c'", c);
+        Error err = create_error(LEXICAL_ERR, error_msg, (unsigned int)(line + i - data));
+        add_error(errorList, err);
+        i++;
     }
-
-    fclose(f);
+    *last_type_io = last_type;
 }
\ No newline at end of file
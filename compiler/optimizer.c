@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "../include/optimizer.h"
+
+// Constant folding and dead-branch elimination over the AST. Nodes are
+// rewritten in place, so parents keep pointing at the same index; nodes that
+// become unreachable are simply left unused in the array.
+
+void init_optimization_report(OptimizationReport *report){
+    report->folded_expressions = 0;
+    report->pruned_branches = 0;
+    report->unrolled_repeats = 0;
+    init_output_buffer(&report->log);
+}
+
+void clear_optimization_report(OptimizationReport *report){
+    report->folded_expressions = 0;
+    report->pruned_branches = 0;
+    report->unrolled_repeats = 0;
+    clear_output_buffer(&report->log);
+}
+
+void free_optimization_report(OptimizationReport *report){
+    free_output_buffer(&report->log);
+}
+
+static void log_change(OptimizationReport *report, int line, const char *message){
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "Line %d: %s\n", line, message);
+    output_buffer_append(&report->log, buffer);
+}
+
+static int is_literal(const Ast *ast, int index){
+    if(index < 0){
+        return 0;
+    }
+    AstKind kind = ast->nodes[index].kind;
+    return kind == AST_INT_LITERAL || kind == AST_REAL_LITERAL || kind == AST_STRING_LITERAL;
+}
+
+static Value literal_value(const AstNode *node){
+    switch(node->kind){
+        case AST_INT_LITERAL: return int_value(node->literal.integer);
+        case AST_REAL_LITERAL: return real_value(node->literal.number);
+        default: return string_value(node->literal.text);
+    }
+}
+
+static void make_literal(AstNode *node, Value value){
+    node->left = -1;
+    node->right = -1;
+    node->type = value.type;
+    if(value.type == KEY_INT){
+        node->kind = AST_INT_LITERAL;
+        node->literal.integer = value.as.i;
+    } else {
+        node->kind = AST_REAL_LITERAL;
+        node->literal.number = value.as.r;
+    }
+}
+
+//counts and logs an operator just replaced by its constant result
+static void log_fold(OptimizationReport *report, const AstNode *node){
+    char message[96];
+    if(node->kind == AST_INT_LITERAL){
+        snprintf(message, sizeof(message), "constant operation folded to %lld", node->literal.integer);
+    } else {
+        snprintf(message, sizeof(message), "constant operation folded to %g", node->literal.number);
+    }
+    report->folded_expressions++;
+    log_change(report, node->line, message);
+}
+
+static void fold_expression(Ast *ast, int index, OptimizationReport *report){
+    if(index < 0){
+        return;
+    }
+
+    AstNode *node = &ast->nodes[index];
+    if(node->kind == AST_NEGATE){
+        fold_expression(ast, node->left, report);
+        if(!is_literal(ast, node->left)){
+            return;
+        }
+        Value operand = literal_value(&ast->nodes[node->left]);
+        if(operand.type == KEY_INT){
+            if(operand.as.i == LLONG_MIN){
+                return; //overflows, left for the executor to report
+            }
+            make_literal(node, int_value(-operand.as.i));
+        } else if(operand.type == KEY_REAL){
+            make_literal(node, real_value(-operand.as.r));
+        } else {
+            return;
+        }
+        log_fold(report, node);
+        return;
+    }
+
+    if(node->kind != AST_BINARY){
+        return;
+    }
+
+    fold_expression(ast, node->left, report);
+    fold_expression(ast, node->right, report);
+    if(!is_literal(ast, node->left) || !is_literal(ast, node->right)){
+        return;
+    }
+
+    Value lhs = literal_value(&ast->nodes[node->left]);
+    Value rhs = literal_value(&ast->nodes[node->right]);
+    if(!value_is_number(&lhs) || !value_is_number(&rhs)){
+        return;
+    }
+
+    if(node->op == OPERATOR_DIVIDE){
+        double r = value_as_real(&rhs);
+        if(r == 0.0){
+            return; //left for the executor to report
+        }
+        make_literal(node, real_value(value_as_real(&lhs) / r));
+    } else if(lhs.type == KEY_INT && rhs.type == KEY_INT){
+        long long result;
+        int overflow = node->op == OPERATOR_PLUS ? __builtin_add_overflow(lhs.as.i, rhs.as.i, &result)
+                     : node->op == OPERATOR_MINUS ? __builtin_sub_overflow(lhs.as.i, rhs.as.i, &result)
+                     : __builtin_mul_overflow(lhs.as.i, rhs.as.i, &result);
+        if(overflow){
+            return; //left for the executor to report
+        }
+        make_literal(node, int_value(result));
+    } else {
+        double l = value_as_real(&lhs);
+        double r = value_as_real(&rhs);
+        double result = node->op == OPERATOR_PLUS ? l + r
+                      : node->op == OPERATOR_MINUS ? l - r
+                      : l * r;
+        make_literal(node, real_value(result));
+    }
+    log_fold(report, node);
+}
+
+//1 or 0 when the condition is a compile-time constant, -1 otherwise
+static int fold_condition(Ast *ast, int index, OptimizationReport *report){
+    if(index < 0){
+        return -1;
+    }
+
+    AstNode *node = &ast->nodes[index];
+    fold_expression(ast, node->left, report);
+    fold_expression(ast, node->right, report);
+    node = &ast->nodes[index];
+    if(!is_literal(ast, node->left) || !is_literal(ast, node->right)){
+        return -1;
+    }
+
+    Value lhs = literal_value(&ast->nodes[node->left]);
+    Value rhs = literal_value(&ast->nodes[node->right]);
+    int cmp;
+    if(!compare_values(&lhs, &rhs, &cmp)){
+        return -1;
+    }
+
+    switch(node->op){
+        case REL_LT: return cmp < 0;
+        case REL_LE: return cmp <= 0;
+        case REL_GT: return cmp > 0;
+        case REL_GE: return cmp >= 0;
+        case REL_NE: return cmp != 0;
+        default: return cmp == 0;
+    }
+}
+
+static void make_empty_block(AstNode *node){
+    node->kind = AST_BLOCK;
+    node->left = -1;
+    node->right = -1;
+    node->extra = -1;
+    node->first_child = 0;
+    node->child_count = 0;
+}
+
+static void optimize_statement(Ast *ast, int index, OptimizationReport *report){
+    if(index < 0){
+        return;
+    }
+
+    AstNode *node = &ast->nodes[index];
+    switch(node->kind){
+        case AST_PROGRAM:
+        case AST_BLOCK:
+        case AST_DECLARATION:
+            for(int i = 0; i < node->child_count; i++){
+                optimize_statement(ast, ast->children[node->first_child + i], report);
+            }
+            break;
+        case AST_ASSIGN:
+            fold_expression(ast, node->left, report);
+            break;
+        case AST_PRINT:
+            for(int i = 0; i < node->child_count; i++){
+                fold_expression(ast, ast->children[node->first_child + i], report);
+            }
+            break;
+        case AST_IF: {
+            int holds = fold_condition(ast, node->left, report);
+            optimize_statement(ast, node->right, report);
+            optimize_statement(ast, node->extra, report);
+            node = &ast->nodes[index];
+            if(holds < 0){
+                break;
+            }
+
+            int kept = holds ? node->right : node->extra;
+            int removed = holds ? node->extra : node->right;
+            if(holds){
+                log_change(report, node->line, removed >= 0
+                    ? "If condition is always true, Else branch removed"
+                    : "If condition is always true, test removed");
+            } else {
+                log_change(report, node->line, "If condition is always false, Then branch removed");
+            }
+            report->pruned_branches += removed >= 0 ? 1 : 0;
+
+            if(kept >= 0){
+                ast->nodes[index] = ast->nodes[kept];
+            } else {
+                make_empty_block(&ast->nodes[index]);
+            }
+            break;
+        }
+        case AST_REPEAT: {
+            for(int i = 0; i < node->child_count; i++){
+                optimize_statement(ast, ast->children[node->first_child + i], report);
+            }
+            int holds = fold_condition(ast, node->left, report);
+            node = &ast->nodes[index];
+            if(holds == 1){
+                //the body runs exactly once
+                node->kind = AST_BLOCK;
+                node->left = -1;
+                report->unrolled_repeats++;
+                log_change(report, node->line, "until condition is always true, Repeat runs once");
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void optimize_program(Ast *ast, OptimizationReport *report){
+    if(ast == NULL || ast->root < 0){
+        return;
+    }
+    optimize_statement(ast, ast->root, report);
+}
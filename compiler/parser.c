@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
+#include <errno.h>
 #include "../include/parser.h"
 #include "../include/token.h"
 #include "../include/symbol.h"
 #include "../include/error.h"
+#include "../include/ast.h"
 
 static void ensure_output_capacity(OutputBuffer *buffer, size_t additional){
     if(buffer == NULL){
@@ -34,6 +37,17 @@ void init_output_buffer(OutputBuffer *buffer){
     buffer->capacity = 0;
 }
 
+//empties the buffer, keeping its memory
+void clear_output_buffer(OutputBuffer *buffer){
+    if(buffer == NULL){
+        return;
+    }
+    buffer->length = 0;
+    if(buffer->data != NULL){
+        buffer->data[0] = '\0';
+    }
+}
+
 void free_output_buffer(OutputBuffer *buffer){
     if(buffer == NULL){
         return;
@@ -55,7 +69,7 @@ char *detach_output_buffer(OutputBuffer *buffer){
     return data;
 }
 
-static void output_buffer_append(OutputBuffer *buffer, const char *text){
+void output_buffer_append(OutputBuffer *buffer, const char *text){
     if(buffer == NULL || text == NULL){
         return;
     }
@@ -69,121 +83,182 @@ static void output_buffer_append(OutputBuffer *buffer, const char *text){
     buffer->data[buffer->length] = '\0';
 }
 
+//formats straight into the spare capacity, growing once if it does not fit
+void output_buffer_printf(OutputBuffer *buffer, const char *format, ...){
+    if(buffer == NULL || format == NULL){
+        return;
+    }
+    ensure_output_capacity(buffer, 0);
+
+    va_list args;
+    va_start(args, format);
+    size_t available = buffer->capacity - buffer->length;
+    int written = vsnprintf(buffer->data + buffer->length, available, format, args);
+    va_end(args);
+    if(written < 0){
+        return;
+    }
+
+    if((size_t)written >= available){
+        ensure_output_capacity(buffer, written);
+        va_start(args, format);
+        vsnprintf(buffer->data + buffer->length, written + 1, format, args);
+        va_end(args);
+    }
+    buffer->length += written;
+}
+
+//has_value is only set for compile-time constants, variables are evaluated
+//later by the interpreter. Strings are referenced, not copied, so the struct
+//stays small enough to return by value through every precedence level.
 typedef struct {
     SymbolType inferred_type;
     int token_count;
-    int has_value;
-    int is_string;
     double numeric_value;
-    char string_value[512];
+    const char *string_value; //interned in the TokenList's pool
     int last_line;
+    int node;
+    unsigned char has_value;
+    unsigned char is_string;
 } ExpressionResult;
 
 typedef struct {
     Parser *parser;
-    const TokenType *terminators;
-    size_t term_count;
+    unsigned int terminators; //bit per TokenType that ends the expression, NONE included
 } ExpressionContext;
 
-void init_parser(Parser *parser, TokenList *tokens, SymbolTable *symbolTable, ErrorList *errors, OutputBuffer *output){
+void init_parser(Parser *parser, TokenList *tokens, SymbolTable *symbolTable, ErrorList *errors, Ast *ast){
     parser->tokens = tokens;
     parser->position = 0;
     parser->symbolTable = symbolTable;
     parser->errors = errors;
-    parser->output = output;
+    parser->ast = ast;
+    parser->log = NULL;
+    memset(&parser->cursor, 0, sizeof(parser->cursor));
+    parser->cursor.index = -1;
 }
 
-static void append_expression_to_output(Parser *parser, const ExpressionResult *expr, int is_first){
-    if(parser == NULL || parser->output == NULL || expr == NULL){
-        return;
+//kind of the current token, NONE past the end; most decisions need nothing else
+static inline TokenType current_kind(Parser *parser){
+    if(parser->tokens == NULL || parser->position >= parser->tokens->count){
+        return NONE;
     }
+    return token_kind(parser->tokens, parser->position);
+}
 
-    if(!is_first){
-        output_buffer_append(parser->output, " ");
+//the cursor follows advance(); when the position is set directly it seeks
+static inline TokenCursor *sync_cursor(Parser *parser){
+    if(parser->cursor.index != parser->position){
+        token_cursor_seek(parser->tokens, &parser->cursor, parser->position);
     }
+    return &parser->cursor;
+}
 
-    if(!expr->has_value){
-        output_buffer_append(parser->output, "<undef>");
-        return;
+//the whole token, with type NONE, line 0 and no offset when there is none
+static inline Token current_token(Parser *parser){
+    Token token = {NONE, 0, NO_SOURCE_OFFSET, ""};
+    TokenType type = current_kind(parser);
+    if(type == NONE){
+        return token;
     }
+    TokenList *tokens = parser->tokens;
+    TokenCursor *cursor = sync_cursor(parser);
+    token.type = type;
+    token.line = cursor->line + 1;
+    token.offset = tokens->offsets[parser->position];
+    token.value = token_has_text(type) ? string_pool_text(&tokens->strings, tokens->texts[cursor->text])
+                                       : token_spelling(type);
+    return token;
+}
 
-    if(expr->inferred_type == KEY_STRING){
-        output_buffer_append(parser->output, expr->string_value);
-        return;
-    }
+//symbol named by the current token, an IDENTIFIER; the pool hashed its text
+//when it was interned, so the lookup does not hash it again
+static Symbol *current_symbol(Parser *parser){
+    TokenList *tokens = parser->tokens;
+    int text = tokens->texts[sync_cursor(parser)->text];
+    return findSymbolHashed(parser->symbolTable, string_pool_text(&tokens->strings, text),
+                            string_pool_hash(&tokens->strings, text));
+}
 
-    char buffer[64];
-    if(expr->inferred_type == KEY_REAL){
-        snprintf(buffer, sizeof(buffer), "%.6g", expr->numeric_value);
-    } else {
-        snprintf(buffer, sizeof(buffer), "%.0f", expr->numeric_value);
+static inline int current_line(Parser *parser){
+    if(current_kind(parser) == NONE){
+        return 0;
     }
-    output_buffer_append(parser->output, buffer);
+    return sync_cursor(parser)->line + 1;
 }
 
-static Token* current_token(Parser *parser){
-    if(parser->tokens == NULL || parser->tokens->count == 0){
-        return NULL;
-    }
-    if(parser->position >= parser->tokens->count){
-        return NULL;
+//offset of the token at index, for errors that point at it
+static unsigned int token_offset(Parser *parser, int index){
+    if(parser->tokens == NULL || index >= parser->tokens->count){
+        return NO_SOURCE_OFFSET;
     }
-    return &parser->tokens->tokens[parser->position];
+    return parser->tokens->offsets[index];
 }
 
-static Token* previous_token(Parser *parser){
-    if(parser->tokens == NULL || parser->tokens->count == 0 || parser->position == 0){
-        return NULL;
-    }
+static unsigned int current_offset(Parser *parser){
+    return token_offset(parser, parser->position);
+}
+
+
+static Token previous_token(Parser *parser){
     int index = parser->position - 1;
-    if(index >= parser->tokens->count){
+    if(parser->tokens != NULL && index >= parser->tokens->count){
         index = parser->tokens->count - 1;
     }
-    return &parser->tokens->tokens[index];
+    if(parser->tokens == NULL || index < 0){
+        Token none = {NONE, 0, NO_SOURCE_OFFSET, ""};
+        return none;
+    }
+    return get_token(parser->tokens, index, NULL);
 }
 
-static void advance(Parser *parser){
+static inline void advance(Parser *parser){
     if(parser->tokens == NULL){
         return;
     }
     if(parser->position < parser->tokens->count){
+        if(parser->cursor.index == parser->position){
+            token_cursor_next(parser->tokens, &parser->cursor);
+        }
         parser->position++;
     }
 }
 
 static int match(Parser *parser, TokenType type){
-    Token *token = current_token(parser);
-    if(token != NULL && token->type == type){
+    if(current_kind(parser) == type){
         advance(parser);
         return 1;
     }
     return 0;
 }
 
-static void add_syntax_error(Parser *parser, const char *message, int line){
-    Error err = create_error(SYNTAX_ERR, message, line);
+static void add_syntax_error(Parser *parser, const char *message, unsigned int offset){
+    Error err = create_error(SYNTAX_ERR, message, offset);
     add_error(parser->errors, err);
 }
 
-static void add_semantic_error(Parser *parser, const char *message, int line){
-    Error err = create_error(SEMANTIC_ERR, message, line);
+static void add_semantic_error(Parser *parser, const char *message, unsigned int offset){
+    Error err = create_error(SEMANTIC_ERR, message, offset);
+    add_error(parser->errors, err);
+}
+
+//errors the parse only knows the line of point at the start of that line
+static void add_line_error(Parser *parser, const char *message, int line){
+    Error err = create_error(SEMANTIC_ERR, message, line_start_offset(&parser->tokens->lines, line));
+    err.at_line_start = 1;
     add_error(parser->errors, err);
 }
 
 static void expect(Parser *parser, TokenType type, const char *message){
-    Token *token = current_token(parser);
-    if(token == NULL){
-        Token *prev = previous_token(parser);
-        int line = prev ? prev->line : 0;
-        add_syntax_error(parser, message, line);
+    TokenType current = current_kind(parser);
+    if(current == NONE){
+        add_syntax_error(parser, message, previous_token(parser).offset);
         return;
     }
-    if(token->type != type){
-        add_syntax_error(parser, message, token->line);
-        advance(parser);
-    } else {
-        advance(parser);
+    if(current != type){
+        add_syntax_error(parser, message, current_token(parser).offset);
     }
+    advance(parser);
 }
 
 static SymbolType token_to_symbol_type(TokenType type){
@@ -203,19 +278,24 @@ static ExpressionResult make_unknown_expression(void){
     ExpressionResult res;
     memset(&res, 0, sizeof(res));
     res.inferred_type = KEY_UNKNOWN;
+    res.node = -1;
     return res;
 }
 
-static int is_expr_terminator(ExpressionContext *ctx, Token *token){
-    if(token == NULL){
-        return 1;
-    }
-    for(size_t i = 0; i < ctx->term_count; i++){
-        if(token->type == ctx->terminators[i]){
-            return 1;
-        }
-    }
-    return 0;
+static int add_node(Parser *parser, AstKind kind, int line){
+    return ast_add_node(parser->ast, kind, line);
+}
+
+static AstNode *node_at(Parser *parser, int index){
+    return &parser->ast->nodes[index];
+}
+
+static int symbol_position(Parser *parser, Symbol *sym){
+    return sym ? (int)(sym - parser->symbolTable->symbols) : -1;
+}
+
+static int is_expr_terminator(ExpressionContext *ctx, TokenType type){
+    return (ctx->terminators >> type) & 1;
 }
 
 static ExpressionResult parse_add_sub(ExpressionContext *ctx);
@@ -223,25 +303,32 @@ static ExpressionResult parse_expression(Parser *parser, const TokenType *termin
 
 static ExpressionResult parse_primary(ExpressionContext *ctx){
     Parser *parser = ctx->parser;
-    Token *token = current_token(parser);
+    Token token = current_token(parser);
     ExpressionResult result = make_unknown_expression();
 
-    if(token == NULL){
+    if(token.type == NONE){
         return result;
     }
 
-    if(is_expr_terminator(ctx, token)){
+    if(is_expr_terminator(ctx, token.type)){
         return result;
     }
 
-    switch(token->type){
+    switch(token.type){
         case INTEGER_LITERAL:
             result.inferred_type = KEY_INT;
             result.token_count = 1;
             result.has_value = 1;
             result.is_string = 0;
-            result.numeric_value = strtod(token->value, NULL);
-            result.last_line = token->line;
+            result.numeric_value = strtod(token.value, NULL);
+            result.last_line = token.line;
+            result.node = add_node(parser, AST_INT_LITERAL, token.line);
+            node_at(parser, result.node)->type = KEY_INT;
+            errno = 0;
+            node_at(parser, result.node)->literal.integer = strtoll(token.value, NULL, 10);
+            if(errno == ERANGE){
+                add_semantic_error(parser, "Integer literal out of range", token.offset);
+            }
             advance(parser);
             break;
         case FLOAT_LITERAL:
@@ -249,8 +336,11 @@ static ExpressionResult parse_primary(ExpressionContext *ctx){
             result.token_count = 1;
             result.has_value = 1;
             result.is_string = 0;
-            result.numeric_value = strtod(token->value, NULL);
-            result.last_line = token->line;
+            result.numeric_value = strtod(token.value, NULL);
+            result.last_line = token.line;
+            result.node = add_node(parser, AST_REAL_LITERAL, token.line);
+            node_at(parser, result.node)->type = KEY_REAL;
+            node_at(parser, result.node)->literal.number = result.numeric_value;
             advance(parser);
             break;
         case STRING_LITERAL:
@@ -258,49 +348,40 @@ static ExpressionResult parse_primary(ExpressionContext *ctx){
             result.token_count = 1;
             result.has_value = 1;
             result.is_string = 1;
-            strncpy(result.string_value, token->value, sizeof(result.string_value) - 1);
-            result.string_value[sizeof(result.string_value) - 1] = '\0';
-            result.last_line = token->line;
+            result.string_value = token.value;
+            result.last_line = token.line;
+            result.node = add_node(parser, AST_STRING_LITERAL, token.line);
+            node_at(parser, result.node)->type = KEY_STRING;
+            node_at(parser, result.node)->literal.text = token.value;
             advance(parser);
             break;
         case IDENTIFIER: {
             result.token_count = 1;
-            result.last_line = token->line;
-            Symbol *sym = findSymbol(parser->symbolTable, token->value);
+            result.last_line = token.line;
+            Symbol *sym = current_symbol(parser);
             if(sym == NULL){
                 char msg[256];
-                sprintf(msg, "Variable '%s' not declared", token->value);
-                add_semantic_error(parser, msg, token->line);
+                snprintf(msg, sizeof(msg), "Variable '%s' not declared", token.value);
+                add_semantic_error(parser, msg, token.offset);
                 advance(parser);
                 break;
             }
 
             result.inferred_type = sym->type;
-            if(sym->value == NULL){
+            if(!sym->assigned){
                 char msg[256];
-                sprintf(msg, "Variable '%s' used before assignment", sym->id);
-                add_semantic_error(parser, msg, token->line);
-                result.has_value = 0;
-            } else if(sym->type == KEY_STRING){
-                result.has_value = 1;
-                result.is_string = 1;
-                strncpy(result.string_value, sym->value, sizeof(result.string_value) - 1);
-                result.string_value[sizeof(result.string_value) - 1] = '\0';
-            } else {
-                result.has_value = 1;
-                result.is_string = 0;
-                result.numeric_value = strtod(sym->value, NULL);
-                if(sym->type == KEY_REAL){
-                    result.inferred_type = KEY_REAL;
-                } else {
-                    result.inferred_type = KEY_INT;
-                }
+                snprintf(msg, sizeof(msg), "Variable '%s' used before assignment", sym->id);
+                add_semantic_error(parser, msg, token.offset);
             }
+            result.is_string = sym->type == KEY_STRING;
+            result.node = add_node(parser, AST_VARIABLE, token.line);
+            node_at(parser, result.node)->type = sym->type;
+            node_at(parser, result.node)->symbol = symbol_position(parser, sym);
             advance(parser);
             break;
         }
         case OPEN_PAREN: {
-            int start_line = token->line;
+            int start_line = token.line;
             advance(parser); // consume '('
             TokenType close = CLOSE_PAREN;
             ExpressionResult inner = parse_expression(parser, &close, 1);
@@ -313,8 +394,8 @@ static ExpressionResult parse_primary(ExpressionContext *ctx){
         }
         default: {
             char msg[256];
-            sprintf(msg, "Unexpected token '%s' in expression", token->value);
-            add_syntax_error(parser, msg, token->line);
+            snprintf(msg, sizeof(msg), "Unexpected token '%s' in expression", token.value);
+            add_syntax_error(parser, msg, token.offset);
             advance(parser);
             break;
         }
@@ -324,15 +405,16 @@ static ExpressionResult parse_primary(ExpressionContext *ctx){
 }
 
 static ExpressionResult parse_unary(ExpressionContext *ctx){
-    Token *token = current_token(ctx->parser);
-    if(token != NULL && token->type == OPERATOR_MINUS){
+    if(current_kind(ctx->parser) == OPERATOR_MINUS){
+        int line = current_line(ctx->parser);
+        int op_index = ctx->parser->position;
         advance(ctx->parser);
         ExpressionResult operand = parse_unary(ctx);
         operand.token_count += 1;
-        operand.last_line = operand.last_line ? operand.last_line : (token ? token->line : 0);
+        operand.last_line = operand.last_line ? operand.last_line : line;
 
         if(operand.inferred_type == KEY_STRING){
-            add_semantic_error(ctx->parser, "Cannot apply unary '-' to a string", token->line);
+            add_semantic_error(ctx->parser, "Cannot apply unary '-' to a string", token_offset(ctx->parser, op_index));
             return make_unknown_expression();
         }
 
@@ -343,32 +425,52 @@ static ExpressionResult parse_unary(ExpressionContext *ctx){
             operand.inferred_type = KEY_INT;
         }
         operand.is_string = 0;
+        if(operand.node >= 0){
+            int negate = add_node(ctx->parser, AST_NEGATE, line);
+            node_at(ctx->parser, negate)->left = operand.node;
+            node_at(ctx->parser, negate)->type = operand.inferred_type;
+            operand.node = negate;
+        }
         return operand;
     }
     return parse_primary(ctx);
 }
 
+//operands that failed to parse leave the whole expression without a node
+static int make_binary_node(Parser *parser, TokenType op, int line, const ExpressionResult *left, const ExpressionResult *right, SymbolType type){
+    if(left->node < 0 || right->node < 0){
+        return -1;
+    }
+    int node = add_node(parser, AST_BINARY, line);
+    node_at(parser, node)->op = op;
+    node_at(parser, node)->left = left->node;
+    node_at(parser, node)->right = right->node;
+    node_at(parser, node)->type = type;
+    return node;
+}
+
 static ExpressionResult parse_mul_div(ExpressionContext *ctx){
     ExpressionResult left = parse_unary(ctx);
     while(1){
-        Token *token = current_token(ctx->parser);
-        if(token == NULL || is_expr_terminator(ctx, token)){
+        TokenType op = current_kind(ctx->parser);
+        if(is_expr_terminator(ctx, op)){
             break;
         }
-        if(token->type != OPERATOR_MULTIPLY && token->type != OPERATOR_DIVIDE){
+        if(op != OPERATOR_MULTIPLY && op != OPERATOR_DIVIDE){
             break;
         }
 
-        TokenType op = token->type;
+        int line = current_line(ctx->parser);
+        int op_index = ctx->parser->position;
         advance(ctx->parser);
         ExpressionResult right = parse_unary(ctx);
 
         ExpressionResult combined = make_unknown_expression();
         combined.token_count = left.token_count + right.token_count + 1;
-        combined.last_line = right.token_count ? right.last_line : token->line;
+        combined.last_line = right.token_count ? right.last_line : line;
 
         if(left.inferred_type == KEY_STRING || right.inferred_type == KEY_STRING){
-            add_semantic_error(ctx->parser, "String values are not allowed in arithmetic expressions", token->line);
+            add_semantic_error(ctx->parser, "String values are not allowed in arithmetic expressions", token_offset(ctx->parser, op_index));
         } else {
             combined.inferred_type = KEY_INT;
             if(left.inferred_type == KEY_REAL || right.inferred_type == KEY_REAL || op == OPERATOR_DIVIDE){
@@ -385,13 +487,16 @@ static ExpressionResult parse_mul_div(ExpressionContext *ctx){
                     combined.numeric_value = lhs * rhs;
                 } else {
                     if(rhs == 0.0){
-                        add_semantic_error(ctx->parser, "Division by zero", token->line);
+                        add_semantic_error(ctx->parser, "Division by zero", token_offset(ctx->parser, op_index));
                         combined.has_value = 0;
+                        left = combined;
+                        continue;
                     } else {
                         combined.numeric_value = lhs / rhs;
                     }
                 }
             }
+            combined.node = make_binary_node(ctx->parser, op, line, &left, &right, combined.inferred_type);
         }
 
         left = combined;
@@ -402,24 +507,25 @@ static ExpressionResult parse_mul_div(ExpressionContext *ctx){
 static ExpressionResult parse_add_sub(ExpressionContext *ctx){
     ExpressionResult left = parse_mul_div(ctx);
     while(1){
-        Token *token = current_token(ctx->parser);
-        if(token == NULL || is_expr_terminator(ctx, token)){
+        TokenType op = current_kind(ctx->parser);
+        if(is_expr_terminator(ctx, op)){
             break;
         }
-        if(token->type != OPERATOR_PLUS && token->type != OPERATOR_MINUS){
+        if(op != OPERATOR_PLUS && op != OPERATOR_MINUS){
             break;
         }
 
-        TokenType op = token->type;
+        int line = current_line(ctx->parser);
+        int op_index = ctx->parser->position;
         advance(ctx->parser);
         ExpressionResult right = parse_mul_div(ctx);
 
         ExpressionResult combined = make_unknown_expression();
         combined.token_count = left.token_count + right.token_count + 1;
-        combined.last_line = right.token_count ? right.last_line : token->line;
+        combined.last_line = right.token_count ? right.last_line : line;
 
         if(left.inferred_type == KEY_STRING || right.inferred_type == KEY_STRING){
-            add_semantic_error(ctx->parser, "String values are not allowed in arithmetic expressions", token->line);
+            add_semantic_error(ctx->parser, "String values are not allowed in arithmetic expressions", token_offset(ctx->parser, op_index));
         } else {
             combined.inferred_type = KEY_INT;
             if(left.inferred_type == KEY_REAL || right.inferred_type == KEY_REAL){
@@ -445,6 +551,7 @@ static ExpressionResult parse_add_sub(ExpressionContext *ctx){
                     combined.numeric_value = lhs - rhs;
                 }
             }
+            combined.node = make_binary_node(ctx->parser, op, line, &left, &right, combined.inferred_type);
         }
 
         left = combined;
@@ -453,12 +560,15 @@ static ExpressionResult parse_add_sub(ExpressionContext *ctx){
 }
 
 static ExpressionResult parse_expression(Parser *parser, const TokenType *terminators, size_t term_count){
-    ExpressionContext ctx = {parser, terminators, term_count};
+    ExpressionContext ctx = {parser, 1u << NONE};
+    for(size_t i = 0; i < term_count; i++){
+        ctx.terminators |= 1u << terminators[i];
+    }
     ExpressionResult result = parse_add_sub(&ctx);
     if(result.token_count == 0){
-        Token *token = current_token(parser);
-        int line = token ? token->line : (previous_token(parser) ? previous_token(parser)->line : 0);
-        add_syntax_error(parser, "Expected expression", line);
+        Token token = current_token(parser);
+        unsigned int at = token.type != NONE ? token.offset : previous_token(parser).offset;
+        add_syntax_error(parser, "Expected expression", at);
     }
     return result;
 }
@@ -479,73 +589,62 @@ static int is_assignment_compatible(SymbolType target, SymbolType source){
     return 1;
 }
 
-static void update_symbol_value(Symbol *sym, const ExpressionResult *expr){
-    if(sym == NULL || expr == NULL){
-        return;
-    }
-    if(sym->value != NULL){
-        free(sym->value);
-        sym->value = NULL;
-    }
-    if(expr->token_count == 0 || !expr->has_value){
-        return;
-    }
+static void log_assigned(ParseLog *log, int symbol);
 
-    if(expr->inferred_type == KEY_STRING){
-        const char *stored = expr->string_value;
-        sym->value = malloc(strlen(stored) + 1);
-        strcpy(sym->value, stored);
-        return;
-    }
-
-    char buffer[64];
-    if(sym->type == KEY_REAL || expr->inferred_type == KEY_REAL){
-        snprintf(buffer, sizeof(buffer), "%.6g", expr->numeric_value);
-    } else {
-        snprintf(buffer, sizeof(buffer), "%.0f", expr->numeric_value);
+static int make_assign_node(Parser *parser, Symbol *sym, const ExpressionResult *expr, int line){
+    if(sym != NULL && expr->token_count > 0){
+        if(!sym->assigned && parser->log != NULL){
+            log_assigned(parser->log, symbol_position(parser, sym));
+        }
+        sym->assigned = 1;
     }
-    sym->value = malloc(strlen(buffer) + 1);
-    strcpy(sym->value, buffer);
+    int node = add_node(parser, AST_ASSIGN, line);
+    node_at(parser, node)->symbol = symbol_position(parser, sym);
+    node_at(parser, node)->left = expr->node;
+    node_at(parser, node)->type = expr->inferred_type;
+    return node;
 }
 
-static void parse_declaration(Parser *parser, TokenType decl_type){
+static int parse_declaration(Parser *parser, TokenType decl_type){
     SymbolType sym_type = token_to_symbol_type(decl_type);
-    Token *type_token = current_token(parser);
-    if(type_token == NULL){
-        return;
+    Token type_token = current_token(parser);
+    if(type_token.type == NONE){
+        return -1;
     }
 
+    int decl = add_node(parser, AST_DECLARATION, type_token.line);
+    int mark = ast_list_mark(parser->ast);
     advance(parser); // consume type keyword
 
     while(1){
-        Token *token = current_token(parser);
-        if(token == NULL){
-            add_syntax_error(parser, "Unexpected end of declaration", type_token->line);
-            return;
+        Token token = current_token(parser);
+        if(token.type == NONE){
+            add_syntax_error(parser, "Unexpected end of declaration", type_token.offset);
+            ast_list_finish(parser->ast, decl, mark);
+            return decl;
         }
 
-        if(token->type != IDENTIFIER){
-            add_syntax_error(parser, "Expected identifier in declaration", token->line);
-            if(token->type == END_INSTRUCTION){
+        if(token.type != IDENTIFIER){
+            add_syntax_error(parser, "Expected identifier in declaration", token.offset);
+            if(token.type == END_INSTRUCTION){
                 break;
             }
             advance(parser);
             continue;
         }
 
-        Symbol *existing = findSymbol(parser->symbolTable, token->value);
+        Symbol *existing = current_symbol(parser);
         if(existing != NULL){
             char msg[256];
-            sprintf(msg, "Variable '%s' already declared at line %d", token->value, existing->line_declared);
-            add_semantic_error(parser, msg, token->line);
+            snprintf(msg, sizeof(msg), "Variable '%s' already declared at line %d", token.value, existing->line_declared);
+            add_semantic_error(parser, msg, token.offset);
         } else {
-            Symbol sym = create_symbol(token->value, sym_type, token->line);
+            Symbol sym = create_symbol(token.value, sym_type, token.line);
             add_symbol(parser->symbolTable, sym);
         }
 
-        char var_name[256];
-        strncpy(var_name, token->value, sizeof(var_name) - 1);
-        var_name[sizeof(var_name) - 1] = '\0';
+        const char *var_name = token.value;
+        int var_line = token.line;
         advance(parser);
 
         if(match(parser, ASSIGN_OP)){
@@ -555,10 +654,10 @@ static void parse_declaration(Parser *parser, TokenType decl_type){
             if(sym != NULL){
                 if(!is_assignment_compatible(sym_type, expr.inferred_type)){
                     char msg[256];
-                    sprintf(msg, "Type mismatch in declaration of '%s'", var_name);
-                    add_semantic_error(parser, msg, expr.last_line ? expr.last_line : sym->line_declared);
+                    snprintf(msg, sizeof(msg), "Type mismatch in declaration of '%s'", var_name);
+                    add_line_error(parser, msg, expr.last_line ? expr.last_line : sym->line_declared);
                 }
-                update_symbol_value(sym, &expr);
+                ast_list_push(parser->ast, make_assign_node(parser, sym, &expr, var_line));
             }
         }
 
@@ -569,27 +668,30 @@ static void parse_declaration(Parser *parser, TokenType decl_type){
     }
 
     expect(parser, END_INSTRUCTION, "Expected '#' at end of declaration");
+    ast_list_finish(parser->ast, decl, mark);
+    return decl;
 }
 
-static void parse_assignment(Parser *parser){
-    Token *id_token = current_token(parser);
-    if(id_token == NULL){
-        return;
+static int parse_assignment(Parser *parser){
+    Token id_token = current_token(parser);
+    if(id_token.type == NONE){
+        return -1;
     }
 
-    if(id_token->type != IDENTIFIER){
-        add_syntax_error(parser, "Expected identifier", id_token->line);
+    if(id_token.type != IDENTIFIER){
+        add_syntax_error(parser, "Expected identifier", id_token.offset);
         advance(parser);
-        return;
+        return -1;
     }
 
-    Symbol *sym = findSymbol(parser->symbolTable, id_token->value);
+    Symbol *sym = current_symbol(parser);
     if(sym == NULL){
         char msg[256];
-        sprintf(msg, "Variable '%s' not declared", id_token->value);
-        add_semantic_error(parser, msg, id_token->line);
+        snprintf(msg, sizeof(msg), "Variable '%s' not declared", id_token.value);
+        add_semantic_error(parser, msg, id_token.offset);
     }
 
+    int line = id_token.line;
     advance(parser); // consume identifier
     expect(parser, ASSIGN_OP, "Expected ':=' operator");
 
@@ -599,57 +701,72 @@ static void parse_assignment(Parser *parser){
     if(sym != NULL){
         if(!is_assignment_compatible(sym->type, expr.inferred_type)){
             char msg[256];
-            sprintf(msg, "Type mismatch while assigning to '%s'", sym->id);
-            add_semantic_error(parser, msg, expr.last_line ? expr.last_line : id_token->line);
+            snprintf(msg, sizeof(msg), "Type mismatch while assigning to '%s'", sym->id);
+            add_line_error(parser, msg, expr.last_line ? expr.last_line : line);
         }
-        update_symbol_value(sym, &expr);
     }
+    int node = make_assign_node(parser, sym, &expr, line);
 
     expect(parser, END_INSTRUCTION, "Expected '#' at end of instruction");
+    return node;
 }
 
-static void parse_print(Parser *parser){
+static int parse_print(Parser *parser, int line){
     int argument_count = 0;
-    int first_value = 1;
+    int node = add_node(parser, AST_PRINT, line);
+    int mark = ast_list_mark(parser->ast);
     while(1){
         TokenType stops[] = {COMMA, END_INSTRUCTION};
         ExpressionResult expr = parse_expression(parser, stops, 2);
         if(expr.token_count == 0){
             break;
         }
-        append_expression_to_output(parser, &expr, first_value);
-        first_value = 0;
+        if(expr.node < 0){
+            //keep the argument so the interpreter prints <undef> in its place
+            expr.node = add_node(parser, AST_VARIABLE, expr.last_line);
+        }
+        ast_list_push(parser->ast, expr.node);
         argument_count++;
         if(match(parser, COMMA)){
             continue;
         }
         break;
     }
+    ast_list_finish(parser->ast, node, mark);
 
     expect(parser, END_INSTRUCTION, "Expected '#' after FRG_Print");
 
     if(argument_count == 0){
-        Token *token = previous_token(parser);
-        int line = token ? token->line : 0;
-        add_syntax_error(parser, "FRG_Print requires at least one argument", line);
-    } else if(parser->output != NULL){
-        output_buffer_append(parser->output, "\n");
+        add_syntax_error(parser, "FRG_Print requires at least one argument", previous_token(parser).offset);
     }
+    return node;
+}
+
+static Relation relation_from_spelling(const char *op){
+    if(strcmp(op, "<") == 0) return REL_LT;
+    if(strcmp(op, "<=") == 0) return REL_LE;
+    if(strcmp(op, ">") == 0) return REL_GT;
+    if(strcmp(op, ">=") == 0) return REL_GE;
+    if(strcmp(op, "!=") == 0) return REL_NE;
+    return REL_EQ;
 }
 
-static void parse_condition(Parser *parser, const char *context){
+static int parse_condition(Parser *parser, const char *context){
     char message[256];
     snprintf(message, sizeof(message), "Expected '[' to start %s condition", context);
+    int node = add_node(parser, AST_CONDITION, current_line(parser));
     expect(parser, OPEN_BRACKET, message);
 
     TokenType left_terms[] = {RELATIONAL_OP, CLOSE_BRACKET};
     ExpressionResult left = parse_expression(parser, left_terms, 2);
 
-    Token *rel = current_token(parser);
-    if(rel == NULL || rel->type != RELATIONAL_OP){
+    Token rel = current_token(parser);
+    if(rel.type != RELATIONAL_OP){
         snprintf(message, sizeof(message), "Expected relational operator in %s condition", context);
-        add_syntax_error(parser, message, rel ? rel->line : (previous_token(parser) ? previous_token(parser)->line : 0));
+        add_syntax_error(parser, message, rel.type != NONE ? rel.offset : previous_token(parser).offset);
+        node_at(parser, node)->op = REL_EQ;
     } else {
+        node_at(parser, node)->op = relation_from_spelling(rel.value);
         advance(parser);
     }
 
@@ -662,56 +779,78 @@ static void parse_condition(Parser *parser, const char *context){
     if(left.inferred_type == KEY_STRING || right.inferred_type == KEY_STRING){
         if(left.inferred_type != KEY_STRING || right.inferred_type != KEY_STRING){
             snprintf(message, sizeof(message), "Cannot compare string with non-string in %s", context);
-            add_semantic_error(parser, message, right.last_line ? right.last_line : left.last_line);
+            add_line_error(parser, message, right.last_line ? right.last_line : left.last_line);
+            return node;
         }
     }
+
+    node_at(parser, node)->left = left.node;
+    node_at(parser, node)->right = right.node;
+    return node;
 }
 
-static void parse_statement(Parser *parser);
+static int parse_statement(Parser *parser);
 
-static void parse_block(Parser *parser){
+static int parse_block(Parser *parser, int line){
+    int node = add_node(parser, AST_BLOCK, line);
+    int mark = ast_list_mark(parser->ast);
     while(1){
-        Token *token = current_token(parser);
-        if(token == NULL || token->type == BLOCK_END){
+        TokenType type = current_kind(parser);
+        if(type == NONE || type == BLOCK_END){
             break;
         }
-        parse_statement(parser);
+        ast_list_push(parser->ast, parse_statement(parser));
     }
+    ast_list_finish(parser->ast, node, mark);
     expect(parser, BLOCK_END, "Expected 'End' to close block");
+    return node;
 }
 
-static void parse_if(Parser *parser){
-    parse_condition(parser, "If");
-    parse_statement(parser);
+static int parse_if(Parser *parser, int line){
+    int node = add_node(parser, AST_IF, line);
+    int condition = parse_condition(parser, "If");
+    int then_branch = parse_statement(parser);
+    int else_branch = -1;
     if(match(parser, KEYWORD_ELSE)){
-        parse_statement(parser);
+        else_branch = parse_statement(parser);
     }
+    node_at(parser, node)->left = condition;
+    node_at(parser, node)->right = then_branch;
+    node_at(parser, node)->extra = else_branch;
+    return node;
 }
 
-static void parse_repeat(Parser *parser){
+static int parse_repeat(Parser *parser, int line){
+    int node = add_node(parser, AST_REPEAT, line);
+    int mark = ast_list_mark(parser->ast);
     while(1){
-        Token *token = current_token(parser);
-        if(token == NULL || token->type == KEYWORD_UNTIL){
+        TokenType type = current_kind(parser);
+        if(type == NONE || type == KEYWORD_UNTIL){
             break;
         }
-        parse_statement(parser);
+        ast_list_push(parser->ast, parse_statement(parser));
     }
+    ast_list_finish(parser->ast, node, mark);
 
     if(!match(parser, KEYWORD_UNTIL)){
-        add_syntax_error(parser, "Expected 'until' to close Repeat block", previous_token(parser) ? previous_token(parser)->line : 0);
-        return;
+        add_syntax_error(parser, "Expected 'until' to close Repeat block", previous_token(parser).offset);
+        return node;
     }
 
-    parse_condition(parser, "until");
+    int condition = parse_condition(parser, "until");
+    node_at(parser, node)->left = condition;
+    return node;
 }
 
-static void parse_statement(Parser *parser){
-    Token *token = current_token(parser);
-    if(token == NULL){
-        return;
+//returns the statement's node, or -1 for comments and unparseable input
+static int parse_statement(Parser *parser){
+    TokenType type = current_kind(parser);
+    if(type == NONE){
+        return -1;
     }
 
-    switch(token->type){
+    int line = current_line(parser);
+    switch(type){
         case COMMENT:
             advance(parser);
             break;
@@ -721,73 +860,456 @@ static void parse_statement(Parser *parser){
         case KEYWORD_INT:
         case KEYWORD_REAL:
         case KEYWORD_STRING:
-            parse_declaration(parser, token->type);
-            break;
+            return parse_declaration(parser, type);
         case IDENTIFIER:
-            parse_assignment(parser);
-            break;
+            return parse_assignment(parser);
         case KEYWORD_PRINT:
             advance(parser);
-            parse_print(parser);
-            break;
+            return parse_print(parser, line);
         case KEYWORD_IF:
             advance(parser);
-            parse_if(parser);
-            break;
+            return parse_if(parser, line);
         case KEYWORD_ELSE:
-            add_syntax_error(parser, "Else without matching If", token->line);
+            add_syntax_error(parser, "Else without matching If", current_offset(parser));
             advance(parser);
             break;
         case BLOCK_BEGIN:
             advance(parser);
-            parse_block(parser);
-            break;
+            return parse_block(parser, line);
         case BLOCK_END:
-            add_syntax_error(parser, "Unexpected 'End'", token->line);
+            add_syntax_error(parser, "Unexpected 'End'", current_offset(parser));
             advance(parser);
             break;
         case KEYWORD_REPEAT:
             advance(parser);
-            parse_repeat(parser);
-            break;
+            return parse_repeat(parser, line);
         case KEYWORD_UNTIL:
-            add_syntax_error(parser, "Unexpected 'until' without Repeat", token->line);
+            add_syntax_error(parser, "Unexpected 'until' without Repeat", current_offset(parser));
             advance(parser);
             break;
         default: {
             char msg[256];
-            sprintf(msg, "Unexpected token '%s'", token->value);
-            add_syntax_error(parser, msg, token->line);
+            snprintf(msg, sizeof(msg), "Unexpected token '%s'", current_token(parser).value);
+            add_syntax_error(parser, msg, current_offset(parser));
             advance(parser);
             break;
         }
     }
+    return -1;
 }
 
-void parse(Parser *parser){
-    if(parser->tokens == NULL || parser->tokens->count == 0){
-        add_syntax_error(parser, "Source is empty", 0);
+static void record_checkpoint(Parser *parser){
+    ParseLog *log = parser->log;
+    if(log->count >= log->capacity){
+        log->capacity = log->capacity == 0 ? 64 : log->capacity * 2;
+        log->checkpoints = realloc(log->checkpoints, sizeof(ParseCheckpoint) * log->capacity);
+    }
+    ParseCheckpoint *checkpoint = &log->checkpoints[log->count++];
+    checkpoint->position = parser->position;
+    checkpoint->node_count = parser->ast->count;
+    checkpoint->child_count = parser->ast->child_count;
+    checkpoint->scratch_count = parser->ast->scratch_count;
+    checkpoint->error_count = parser->errors->count;
+    checkpoint->symbol_count = parser->symbolTable->count;
+    checkpoint->assigned_count = log->assigned_count;
+}
+
+static void log_assigned(ParseLog *log, int symbol){
+    if(log->assigned_count >= log->assigned_capacity){
+        log->assigned_capacity = log->assigned_capacity == 0 ? 32 : log->assigned_capacity * 2;
+        log->assigned = realloc(log->assigned, sizeof(int) * log->assigned_capacity);
+    }
+    log->assigned[log->assigned_count++] = symbol;
+}
+
+//Results of the previous parse from the resume point on. They stay where
+//they are while the re-parse appends its own behind them; when the re-parse
+//reaches a statement past the edit in the same state the old parse was in
+//there, the old results from that statement on are moved up behind the new
+//ones, and the rest of the program is not parsed again.
+struct ParseTail {
+    const TokenEdit *edit;
+    ParseCheckpoint base;           //checkpoint the re-parse resumed from
+    ParseCheckpoint end;            //counts the old parse finished with
+    int first_checkpoint;           //old checkpoints after base, from here to end.position
+    int *assigned;
+    int assigned_count;
+    Symbol *symbols;                //the table is rolled back, so these are copies
+    int symbol_count;
+    int program;                    //children index of the old program's list
+    int program_count;
+    Arena strings;                  //copies of the symbol ids
+};
+
+static void *copy_array(const void *items, int count, size_t size){
+    void *copy = malloc(size * (size_t)(count > 0 ? count : 1));
+    if(count > 0){
+        memcpy(copy, items, size * (size_t)count);
+    }
+    return copy;
+}
+
+//notes the end of the previous results past checkpoint `resume`; only the
+//symbols and the assigned log are copied, since they are rolled back
+static struct ParseTail *save_tail(Parser *parser, ParseLog *log, int resume, const TokenEdit *edit){
+    struct ParseTail *tail = calloc(1, sizeof(struct ParseTail));
+    ParseCheckpoint base = log->checkpoints[resume];
+    Ast *ast = parser->ast;
+    SymbolTable *table = parser->symbolTable;
+    tail->edit = edit;
+    tail->base = base;
+    tail->first_checkpoint = resume + 1;
+    tail->end.position = log->count;
+    tail->end.node_count = ast->count;
+    tail->end.child_count = ast->child_count;
+    tail->end.error_count = parser->errors->count;
+    tail->program = ast->nodes[ast->root].first_child;
+    tail->program_count = ast->nodes[ast->root].child_count;
+
+    tail->assigned_count = log->assigned_count - base.assigned_count;
+    tail->assigned = copy_array(log->assigned + base.assigned_count, tail->assigned_count, sizeof(int));
+    tail->symbol_count = table->count - base.symbol_count;
+    tail->symbols = copy_array(table->symbols + base.symbol_count, tail->symbol_count, sizeof(Symbol));
+    for(int i = 0; i < tail->symbol_count; i++){
+        tail->symbols[i].id = arena_strdup(&tail->strings, tail->symbols[i].id);
+    }
+    return tail;
+}
+
+static void free_tail(struct ParseTail *tail){
+    arena_free(&tail->strings);
+    free(tail->assigned);
+    free(tail->symbols);
+    free(tail);
+}
+
+static int has_child_list(AstKind kind){
+    return kind == AST_BLOCK || kind == AST_DECLARATION || kind == AST_PRINT || kind == AST_REPEAT;
+}
+
+static void reserve_items(void **items, int *capacity, int count, size_t size){
+    if(count <= *capacity){
         return;
     }
+    while(*capacity < count){
+        *capacity = *capacity == 0 ? 64 : *capacity * 2;
+    }
+    *items = realloc(*items, size * (size_t)*capacity);
+}
 
-    if(!match(parser, KEYWORD_BEGIN)){
-        Token *token = current_token(parser);
-        int line = token ? token->line : 0;
-        add_syntax_error(parser, "Program must start with FRG_Begin", line);
+//moves the items the re-parse appended, [end, count), down to `base`, and the
+//old items [old, kept_end) right behind them; returns the new count. The old
+//items only move when the re-parse made a different number than it replaced.
+static int splice_items(void *items, size_t size, int base, int old, int kept_end, int end, int count){
+    char *data = items;
+    int fresh = count - end;
+    int kept = kept_end - old;
+    if(base + fresh != old && kept > 0){
+        void *copy = copy_array(data + (size_t)end * size, fresh, size);
+        memmove(data + (size_t)(base + fresh) * size, data + (size_t)old * size, (size_t)kept * size);
+        memcpy(data + (size_t)base * size, copy, (size_t)fresh * size);
+        free(copy);
+    }else if(fresh > 0){
+        memmove(data + (size_t)base * size, data + (size_t)end * size, (size_t)fresh * size);
+    }
+    return base + fresh + kept;
+}
+
+//shifts node and child list references of nodes [first, last) that point at
+//or past `from` and `child_from`
+static void shift_nodes(Ast *ast, int first, int last, int from, int node_delta, int child_from, int child_delta){
+    if(node_delta == 0 && child_delta == 0){
+        return;
+    }
+    for(int i = first; i < last; i++){
+        AstNode *node = &ast->nodes[i];
+        if(node->left >= from) node->left += node_delta;
+        if(node->right >= from) node->right += node_delta;
+        if(node->extra >= from) node->extra += node_delta;
+        if(has_child_list(node->kind) && node->first_child >= child_from){
+            node->first_child += child_delta;
+        }
+    }
+}
+
+static void shift_children(Ast *ast, int first, int last, int delta){
+    if(delta == 0){
+        return;
+    }
+    for(int i = first; i < last; i++){
+        ast->children[i] += delta;
+    }
+}
+
+//moves the re-parse's results down to where the old ones from tail
+//checkpoint m (end.position for none) started, keeping the old ones from m
+//on behind them, and renumbers both
+static void splice_tail(Parser *parser, int m){
+    ParseLog *log = parser->log;
+    struct ParseTail *tail = log->tail;
+    ParseCheckpoint base = tail->base;
+    ParseCheckpoint end = tail->end;
+    int reused = tail->first_checkpoint + m < end.position;
+    ParseCheckpoint old = reused ? log->checkpoints[tail->first_checkpoint + m] : end;
+    if(!reused){
+        old.child_count = tail->program;
+    }
+    Ast *ast = parser->ast;
+    ErrorList *errors = parser->errors;
+
+    //where the old results were and where they are going
+    int fresh_nodes = ast->count - end.node_count;
+    int fresh_children = ast->child_count - end.child_count;
+    int fresh_errors = errors->count - end.error_count;
+    int node_gap = end.node_count - base.node_count;
+    int child_gap = end.child_count - base.child_count;
+    int error_gap = end.error_count - base.error_count;
+    int node_delta = base.node_count + fresh_nodes - old.node_count;
+    int child_delta = base.child_count + fresh_children - old.child_count;
+    int error_delta = base.error_count + fresh_errors - old.error_count;
+    int scratch_delta = ast->scratch_count - old.scratch_count;
+
+    //the re-parse's statements are numbered behind the old results
+    for(int i = base.scratch_count; i < ast->scratch_count; i++){
+        ast->scratch[i] -= node_gap;
+    }
+    if(reused){
+        for(int i = old.symbol_count - base.symbol_count; i < tail->symbol_count; i++){
+            Symbol sym = tail->symbols[i];
+            sym.assigned = 0;
+            add_symbol(parser->symbolTable, sym);
+        }
+        for(int i = old.assigned_count - base.assigned_count; i < tail->assigned_count; i++){
+            log_assigned(log, tail->assigned[i]);
+            parser->symbolTable->symbols[tail->assigned[i]].assigned = 1;
+        }
+
+        //the old program's statements from m on, before its list is dropped
+        reserve_items((void **)&ast->scratch, &ast->scratch_capacity, ast->scratch_count + tail->program_count, sizeof(int));
+        for(int i = 0; i < tail->program_count; i++){
+            int statement = ast->children[tail->program + i];
+            if(statement >= old.node_count){
+                ast->scratch[ast->scratch_count++] = statement + node_delta;
+            }
+        }
+    }
+
+    ast->count = splice_items(ast->nodes, sizeof(AstNode), base.node_count, old.node_count, end.node_count,
+                              end.node_count, ast->count);
+    shift_nodes(ast, base.node_count, base.node_count + fresh_nodes, end.node_count, -node_gap, end.child_count, -child_gap);
+    shift_nodes(ast, base.node_count + fresh_nodes, ast->count, 0, node_delta, 0, child_delta);
+
+    //the old program's list is left out, ast_list_finish makes a new one
+    ast->child_count = splice_items(ast->children, sizeof(int), base.child_count, old.child_count, tail->program,
+                                    end.child_count, ast->child_count);
+    shift_children(ast, base.child_count, base.child_count + fresh_children, -node_gap);
+    shift_children(ast, base.child_count + fresh_children, ast->child_count, node_delta);
+
+    //messages of the dropped errors stay in the arena until it is compacted
+    log->dropped_messages += old.error_count - base.error_count;
+    errors->count = splice_items(errors->errors, sizeof(Error), base.error_count, old.error_count, end.error_count,
+                                 end.error_count, errors->count);
+    //the old errors past the edit point at text that has moved since
+    for(int i = base.error_count + fresh_errors; i < errors->count; i++){
+        Error *err = &errors->errors[i];
+        if(err->offset != NO_SOURCE_OFFSET && err->offset >= tail->edit->text_end){
+            err->offset = (unsigned int)((long long)err->offset + tail->edit->text_delta);
+        }
+    }
+
+    int first = tail->first_checkpoint - 1;
+    int fresh_checkpoints = log->count - end.position;
+    log->count = splice_items(log->checkpoints, sizeof(ParseCheckpoint), first, tail->first_checkpoint + m,
+                              end.position, end.position, log->count);
+    for(int i = first; i < first + fresh_checkpoints; i++){
+        ParseCheckpoint *checkpoint = &log->checkpoints[i];
+        checkpoint->node_count -= node_gap;
+        checkpoint->child_count -= child_gap;
+        checkpoint->error_count -= error_gap;
+    }
+    for(int i = first + fresh_checkpoints; i < log->count; i++){
+        ParseCheckpoint *checkpoint = &log->checkpoints[i];
+        checkpoint->position += tail->edit->delta;
+        checkpoint->node_count += node_delta;
+        checkpoint->child_count += child_delta;
+        checkpoint->scratch_count += scratch_delta;
+        checkpoint->error_count += error_delta;
+    }
+}
+
+//true when the statement at the current position was parsed before, with
+//the same symbols declared and assigned, so nothing after it can change
+static int try_resync(Parser *parser){
+    ParseLog *log = parser->log;
+    struct ParseTail *tail = log->tail;
+    if(parser->position < tail->edit->end){
+        return 0;
+    }
+
+    const ParseCheckpoint *checkpoints = log->checkpoints + tail->first_checkpoint;
+    int old_position = parser->position - tail->edit->delta;
+    int low = 0;
+    int high = tail->end.position - tail->first_checkpoint - 1;
+    int m = -1;
+    while(low <= high){
+        int mid = (low + high) / 2;
+        if(checkpoints[mid].position == old_position){
+            m = mid;
+            break;
+        }
+        if(checkpoints[mid].position < old_position){
+            low = mid + 1;
+        }else{
+            high = mid - 1;
+        }
+    }
+    if(m < 0){
+        return 0;
+    }
+
+    ParseCheckpoint old = checkpoints[m];
+    SymbolTable *table = parser->symbolTable;
+    if(table->count != old.symbol_count){
+        return 0;
+    }
+    for(int i = tail->base.symbol_count; i < table->count; i++){
+        const Symbol *now = &table->symbols[i];
+        const Symbol *then = &tail->symbols[i - tail->base.symbol_count];
+        if(now->type != then->type || now->line_declared != then->line_declared || strcmp(now->id, then->id) != 0){
+            return 0;
+        }
+    }
+    int assigned = log->assigned_count - tail->base.assigned_count;
+    if(assigned != old.assigned_count - tail->base.assigned_count){
+        return 0;
+    }
+    if(assigned > 0 && memcmp(log->assigned + tail->base.assigned_count, tail->assigned, sizeof(int) * assigned) != 0){
+        return 0;
     }
 
+    splice_tail(parser, m);
+    return 1;
+}
+
+//parses top-level statements up to FRG_End and closes the program
+static void parse_program_body(Parser *parser, int mark){
     while(1){
-        Token *token = current_token(parser);
-        if(token == NULL || token->type == KEYWORD_END){
+        TokenType type = current_kind(parser);
+        if(type == NONE || type == KEYWORD_END){
             break;
         }
-        parse_statement(parser);
+        if(parser->log != NULL){
+            //the old tail already holds the FRG_End check
+            if(parser->log->tail != NULL && try_resync(parser)){
+                ast_list_finish(parser->ast, parser->ast->root, mark);
+                return;
+            }
+            record_checkpoint(parser);
+        }
+        ast_list_push(parser->ast, parse_statement(parser));
+    }
+    if(parser->log != NULL && parser->log->tail != NULL){
+        //never back in step: none of the old results past the edit are kept
+        struct ParseTail *tail = parser->log->tail;
+        splice_tail(parser, tail->end.position - tail->first_checkpoint);
+        parser->log->tail = NULL;
     }
+    ast_list_finish(parser->ast, parser->ast->root, mark);
 
     if(!match(parser, KEYWORD_END)){
-        Token *token = previous_token(parser);
-        int line = token ? token->line : 0;
-        add_syntax_error(parser, "Program must end with FRG_End", line);
+        add_syntax_error(parser, "Program must end with FRG_End", previous_token(parser).offset);
+    }
+}
+
+void parse(Parser *parser){
+    parser->ast->root = add_node(parser, AST_PROGRAM, 0);
+
+    if(parser->tokens == NULL || parser->tokens->count == 0){
+        add_syntax_error(parser, "Source is empty", NO_SOURCE_OFFSET);
+        return;
+    }
+
+    if(!match(parser, KEYWORD_BEGIN)){
+        add_syntax_error(parser, "Program must start with FRG_Begin", current_token(parser).offset);
+    }
+
+    int mark = ast_list_mark(parser->ast);
+    if(parser->log != NULL){
+        parser->log->program_mark = mark;
     }
+    parse_program_body(parser, mark);
 }
 
+void init_parse_log(ParseLog *log){
+    memset(log, 0, sizeof(*log));
+}
+
+void free_parse_log(ParseLog *log){
+    free(log->checkpoints);
+    free(log->assigned);
+    init_parse_log(log);
+}
+
+//Re-parses after an edit of the token list. It resumes at the statement
+//holding the token just before the change, since that statement may have
+//peeked at the changed token (an Else after If); everything parsed before it
+//is kept. Unless lines moved, it stops again at the first later statement
+//where the parse is back in step with the previous one.
+void parse_incremental(Parser *parser, ParseLog *log, const TokenEdit *edit){
+    parser->log = log;
+
+    int resume = -1;
+    for(int i = log->count - 1; i >= 0; i--){
+        if(log->checkpoints[i].position < edit->first){
+            resume = i;
+            break;
+        }
+    }
+
+    if(resume < 0){
+        free_ast(parser->ast);
+        clear_error_list(parser->errors);
+        truncate_symbol_table(parser->symbolTable, 0);
+        log->count = 0;
+        log->assigned_count = 0;
+        log->dropped_messages = 0;
+        parser->position = 0;
+        parse(parser);
+        return;
+    }
+
+    //without lines moving, the old results stay in place behind the re-parse
+    //until it is known which of them are kept
+    ParseCheckpoint checkpoint = log->checkpoints[resume];
+    struct ParseTail *tail = edit->lines_moved ? NULL : save_tail(parser, log, resume, edit);
+
+    Ast *ast = parser->ast;
+    ast->scratch_count = checkpoint.scratch_count;
+    if(tail == NULL){
+        ast->count = checkpoint.node_count;
+        ast->child_count = checkpoint.child_count;
+        //errors are spliced out of order, so their messages are not rewound
+        log->dropped_messages += parser->errors->count - checkpoint.error_count;
+        parser->errors->count = checkpoint.error_count;
+        log->count = resume;
+    }
+    truncate_symbol_table(parser->symbolTable, checkpoint.symbol_count);
+    for(int i = checkpoint.assigned_count; i < log->assigned_count; i++){
+        if(log->assigned[i] < parser->symbolTable->count){
+            parser->symbolTable->symbols[log->assigned[i]].assigned = 0;
+        }
+    }
+    log->assigned_count = checkpoint.assigned_count;
+
+    parser->position = checkpoint.position;
+    log->tail = tail;
+    parse_program_body(parser, log->program_mark);
+    log->tail = NULL;
+    if(tail != NULL){
+        free_tail(tail);
+    }
+    if(log->dropped_messages > parser->errors->count + 64){
+        compact_error_list(parser->errors);
+        log->dropped_messages = 0;
+    }
+}
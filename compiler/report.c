@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/report.h"
+
+static const char *token_names[] = {
+    "NONE",
+    "KEYWORD_BEGIN",
+    "KEYWORD_END",
+    "KEYWORD_INT",
+    "KEYWORD_REAL",
+    "KEYWORD_STRING",
+    "KEYWORD_PRINT",
+    "KEYWORD_IF",
+    "KEYWORD_ELSE",
+    "KEYWORD_REPEAT",
+    "KEYWORD_UNTIL",
+    "BLOCK_BEGIN",
+    "BLOCK_END",
+    "IDENTIFIER",
+    "INTEGER_LITERAL",
+    "FLOAT_LITERAL",
+    "STRING_LITERAL",
+    "ASSIGN_OP",
+    "END_INSTRUCTION",
+    "COMMENT",
+    "COMMA",
+    "OPEN_BRACKET",
+    "CLOSE_BRACKET",
+    "OPEN_PAREN",
+    "CLOSE_PAREN",
+    "OPERATOR_PLUS",
+    "OPERATOR_MINUS",
+    "OPERATOR_MULTIPLY",
+    "OPERATOR_DIVIDE",
+    "RELATIONAL_OP"
+};
+
+static const char *type_names[] = {"Integer", "Real", "String", "Unknown"};
+
+const char *token_type_name(TokenType type){
+    return token_names[type];
+}
+
+const char *symbol_type_name(SymbolType type){
+    return type_names[type];
+}
+
+const char *error_kind_name(ErrorType type){
+    switch(type){
+        case LEXICAL_ERR: return "Lexical";
+        case SYNTAX_ERR: return "Syntax";
+        case SEMANTIC_ERR: return "Semantic";
+    }
+    return "";
+}
+
+static void write_banner(OutputBuffer *out, const char *title){
+    output_buffer_append(out, "========================================\n");
+    output_buffer_append(out, title);
+    output_buffer_append(out, "\n========================================\n");
+}
+
+//writes "Line N: message" for every error of one kind, returns how many
+static int write_errors(const Analysis *analysis, ErrorType type, OutputBuffer *out){
+    int count = 0;
+    for(int i = 0; i < analysis->errorList.count; i++){
+        const Error *err = &analysis->errorList.errors[i];
+        if(err->type == type){
+            output_buffer_printf(out, "Line %d: %s\n", source_line(&analysis->tokenList.lines, err->offset, NULL), err->err_message);
+            count++;
+        }
+    }
+    return count;
+}
+
+void write_lexical_report(const Analysis *analysis, OutputBuffer *out){
+    write_banner(out, "      LEXICAL ANALYSIS RESULTS");
+    output_buffer_append(out, "\n");
+
+    //the tokens themselves are listed by the GUI's virtualized Tokens table
+    output_buffer_printf(out, "Total Tokens: %d (listed in the Tokens tab)\n", analysis->tokenList.count);
+
+    output_buffer_append(out, "\n");
+    write_banner(out, "           LEXICAL ERRORS");
+    int error_count = write_errors(analysis, LEXICAL_ERR, out);
+    if(error_count == 0){
+        output_buffer_append(out, "No lexical errors found! ✓\n");
+    }
+    output_buffer_printf(out, "\nTotal Lexical Errors: %d\n", error_count);
+}
+
+void write_syntax_report(const Analysis *analysis, OutputBuffer *out){
+    write_banner(out, "       SYNTAX ANALYSIS RESULTS");
+    output_buffer_append(out, "\n");
+
+    int error_count = write_errors(analysis, SYNTAX_ERR, out);
+    if(error_count == 0){
+        output_buffer_append(out, "No syntax errors found! ✓\n\n");
+        output_buffer_append(out, "Program structure is correct:\n");
+        output_buffer_append(out, "- Starts with FRG_Begin\n");
+        output_buffer_append(out, "- Ends with FRG_End\n");
+        output_buffer_append(out, "- All instructions properly terminated with #\n");
+    }else{
+        output_buffer_printf(out, "\nTotal Syntax Errors: %d\n", error_count);
+    }
+}
+
+void write_semantic_report(const Analysis *analysis, OutputBuffer *out){
+    write_banner(out, "      SEMANTIC ANALYSIS RESULTS");
+    output_buffer_append(out, "\n");
+
+    int error_count = write_errors(analysis, SEMANTIC_ERR, out);
+    if(error_count == 0){
+        output_buffer_append(out, "No semantic errors found! ✓\n\n");
+    }else{
+        output_buffer_printf(out, "\nTotal Semantic Errors: %d\n\n", error_count);
+    }
+
+    write_banner(out, "          SYMBOL TABLE");
+    output_buffer_append(out, "\n");
+    if(analysis->symbolTable.count == 0){
+        output_buffer_append(out, "(No variables declared)\n");
+    }else{
+        output_buffer_printf(out, "%d variable(s), listed in the Symbols tab\n", analysis->symbolTable.count);
+    }
+
+    output_buffer_append(out, "\n");
+    write_banner(out, "          OPTIMIZATIONS");
+    output_buffer_append(out, "\n");
+    if(analysis->optimization.log.length > 0){
+        output_buffer_append(out, analysis->optimization.log.data);
+    }else{
+        output_buffer_append(out, "No constant expressions or dead branches found.\n");
+    }
+}
+
+void write_variables_report(const Analysis *analysis, OutputBuffer *out){
+    write_banner(out, "        DECLARED VARIABLES");
+    output_buffer_append(out, "\n");
+
+    if(analysis->symbolTable.count == 0){
+        output_buffer_append(out, "No variables declared yet.\n");
+    }else{
+        output_buffer_printf(out, "Total Variables: %d (values in the Symbols tab)\n", analysis->symbolTable.count);
+    }
+
+    output_buffer_append(out, "\n");
+    write_banner(out, "          PROGRAM OUTPUT");
+    output_buffer_append(out, "\n");
+
+    if(analysis->output.length > 0){
+        output_buffer_append(out, analysis->output.data);
+    }else{
+        output_buffer_append(out, "No FRG_Print output generated.\n");
+    }
+    if(out->length == 0 || out->data[out->length - 1] != '\n'){
+        output_buffer_append(out, "\n");
+    }
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "../include/bytecode.h"
+
+// Stack VM for chunks produced by compile_program(). Values stay typed
+// (int64/double/string) for the whole run; slots are copied back into the
+// SymbolTable once the program halts.
+
+static void print_values(OutputBuffer *output, const Value *values, int count){
+    if(output == NULL){
+        return;
+    }
+    for(int i = 0; i < count; i++){
+        if(i > 0){
+            output_buffer_append(output, " ");
+        }
+        char buffer[64];
+        const char *text = format_value(&values[i], buffer, sizeof(buffer));
+        output_buffer_append(output, text ? text : "<undef>");
+    }
+    output_buffer_append(output, "\n");
+}
+
+//returns 1, 0, or -1 when the operands cannot be compared
+static int holds(const Value *lhs, const Value *rhs, Relation rel){
+    int cmp;
+    if(!compare_values(lhs, rhs, &cmp)){
+        return -1;
+    }
+
+    switch(rel){
+        case REL_LT: return cmp < 0;
+        case REL_LE: return cmp <= 0;
+        case REL_GT: return cmp > 0;
+        case REL_GE: return cmp >= 0;
+        case REL_NE: return cmp != 0;
+        default: return cmp == 0;
+    }
+}
+
+static void runtime_error(ErrorList *errors, const LineMap *lines, const char *message, int line){
+    Error err = create_error(SEMANTIC_ERR, message, line_start_offset(lines, line));
+    add_error(errors, err);
+}
+
+//grows one of the chunk's scratch arrays to hold count items
+static void *reserve_scratch(void *items, int *capacity, int count, size_t size){
+    if(count <= *capacity && items != NULL){
+        return items;
+    }
+    *capacity = count > 0 ? count : 1;
+    free(items);
+    return malloc(size * (size_t)*capacity);
+}
+
+void run_chunk(Chunk *chunk, SymbolTable *symbolTable, ErrorList *errors, const LineMap *lines, OutputBuffer *output){
+    //the scratch arrays stay with the chunk, so running it again allocates nothing
+    chunk->slots = reserve_scratch(chunk->slots, &chunk->slot_capacity, chunk->slot_count, sizeof(Value));
+    chunk->stack = reserve_scratch(chunk->stack, &chunk->stack_capacity, chunk->max_stack, sizeof(Value));
+    chunk->loops = reserve_scratch(chunk->loops, &chunk->loop_capacity, chunk->loop_count, sizeof(long));
+    Value *slots = chunk->slots;
+    Value *stack = chunk->stack;
+    long *loops = chunk->loops;
+    memset(slots, 0, sizeof(Value) * (size_t)chunk->slot_count);
+    memset(loops, 0, sizeof(long) * (size_t)chunk->loop_count);
+    for(int i = 0; i < chunk->slot_count; i++){
+        slots[i].type = KEY_UNKNOWN;
+    }
+
+    const Instruction *code = chunk->code;
+    Value *sp = stack;
+    int pc = 0;
+
+    for(;;){
+        const Instruction *ins = &code[pc++];
+        switch((OpCode)ins->op){
+            case OP_CONST:
+                *sp++ = chunk->constants[ins->a];
+                break;
+            case OP_UNDEF:
+                sp->type = KEY_UNKNOWN;
+                sp++;
+                break;
+            case OP_LOAD:
+                *sp++ = slots[ins->a];
+                break;
+            case OP_STORE:
+                slots[ins->a] = *--sp;
+                break;
+            case OP_STORE_REAL:
+                --sp;
+                if(sp->type == KEY_INT){
+                    sp->as.r = (double)sp->as.i;
+                    sp->type = KEY_REAL;
+                }
+                slots[ins->a] = *sp;
+                break;
+            case OP_POP:
+                --sp;
+                break;
+            case OP_NEG: {
+                Value *v = sp - 1;
+                if(v->type == KEY_INT){
+                    if(v->as.i == LLONG_MIN){
+                        runtime_error(errors, lines, "Integer overflow", chunk->lines[pc - 1]);
+                        goto halt;
+                    }
+                    v->as.i = -v->as.i;
+                } else if(v->type == KEY_REAL){
+                    v->as.r = -v->as.r;
+                } else {
+                    v->type = KEY_UNKNOWN;
+                }
+                break;
+            }
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL: {
+                Value *rhs = --sp;
+                Value *lhs = sp - 1;
+                if(lhs->type == KEY_INT && rhs->type == KEY_INT){
+                    int overflow;
+                    if(ins->op == OP_ADD){
+                        overflow = __builtin_add_overflow(lhs->as.i, rhs->as.i, &lhs->as.i);
+                    } else if(ins->op == OP_SUB){
+                        overflow = __builtin_sub_overflow(lhs->as.i, rhs->as.i, &lhs->as.i);
+                    } else {
+                        overflow = __builtin_mul_overflow(lhs->as.i, rhs->as.i, &lhs->as.i);
+                    }
+                    if(overflow){
+                        runtime_error(errors, lines, "Integer overflow", chunk->lines[pc - 1]);
+                        goto halt;
+                    }
+                } else if(value_is_number(lhs) && value_is_number(rhs)){
+                    double l = value_as_real(lhs);
+                    double r = value_as_real(rhs);
+                    lhs->type = KEY_REAL;
+                    if(ins->op == OP_ADD){
+                        lhs->as.r = l + r;
+                    } else if(ins->op == OP_SUB){
+                        lhs->as.r = l - r;
+                    } else {
+                        lhs->as.r = l * r;
+                    }
+                } else {
+                    lhs->type = KEY_UNKNOWN;
+                }
+                break;
+            }
+            case OP_DIV: {
+                Value *rhs = --sp;
+                Value *lhs = sp - 1;
+                if(!value_is_number(lhs) || !value_is_number(rhs)){
+                    lhs->type = KEY_UNKNOWN;
+                    break;
+                }
+                double r = value_as_real(rhs);
+                if(r == 0.0){
+                    runtime_error(errors, lines, "Division by zero", chunk->lines[pc - 1]);
+                    goto halt;
+                }
+                lhs->as.r = value_as_real(lhs) / r;
+                lhs->type = KEY_REAL;
+                break;
+            }
+            case OP_COMPARE: {
+                Value *rhs = --sp;
+                Value *lhs = sp - 1;
+                int result = holds(lhs, rhs, (Relation)ins->a);
+                if(result < 0){
+                    lhs->type = KEY_UNKNOWN;
+                } else {
+                    lhs->type = KEY_INT;
+                    lhs->as.i = result;
+                }
+                break;
+            }
+            case OP_PRINT:
+                sp -= ins->a;
+                print_values(output, sp, ins->a);
+                break;
+            case OP_JUMP:
+                pc = ins->a;
+                break;
+            case OP_BRANCH:
+                --sp;
+                if(sp->type == KEY_UNKNOWN){
+                    pc = ins->b;
+                } else if(sp->as.i == 0){
+                    pc = ins->a;
+                }
+                break;
+            case OP_REPEAT_ENTER:
+                loops[ins->a] = 0;
+                break;
+            case OP_REPEAT_BACK:
+                --sp;
+                if(sp->type != KEY_UNKNOWN && sp->as.i == 0){
+                    if(++loops[ins->a] >= MAX_REPEAT_ITERATIONS){
+                        char msg[128];
+                        snprintf(msg, sizeof(msg), "Repeat loop did not reach its until condition after %d iterations", MAX_REPEAT_ITERATIONS);
+                        runtime_error(errors, lines, msg, chunk->lines[pc - 1]);
+                        goto halt;
+                    }
+                    pc = ins->b;
+                }
+                break;
+            case OP_HALT:
+                goto halt;
+        }
+    }
+
+halt:
+    for(int i = 0; i < symbolTable->count && i < chunk->slot_count; i++){
+        symbolTable->symbols[i].value = slots[i];
+    }
+}
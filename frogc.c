@@ -0,0 +1,621 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "include/token.h"
+#include "include/error.h"
+#include "include/symbol.h"
+#include "include/lexer.h"
+#include "include/source.h"
+#include "include/parser.h"
+#include "include/interpreter.h"
+#include "include/bytecode.h"
+#include "include/optimizer.h"
+#include "include/context.h"
+#include "include/cache.h"
+
+// Headless driver: runs the lexical/syntax/semantic passes over a batch of
+// .FRG files in a single process and prints diagnostics plus timing. Files
+// are spread over worker threads; each worker compiles its files one after
+// another in its own CompilationContext, and their diagnostics are buffered
+// and printed in input order, so the output does not depend on the job count.
+// With --cache, the tokens and diagnostics of every parsed file are kept on
+// disk by content, and a file seen before is neither lexed nor parsed again.
+
+typedef enum {
+    STAGE_LEX,
+    STAGE_SYNTAX,
+    STAGE_SEMANTIC
+} Stage;
+
+typedef struct {
+    char **paths;
+    int count;
+    int capacity;
+} PathList;
+
+typedef enum {
+    EXEC_VM,
+    EXEC_AST
+} Executor;
+
+typedef struct {
+    Stage stage;
+    int quiet;
+    int print_output;
+    int optimize;
+    Executor executor;
+    int jobs;
+    const char *cache_directory;    // NULL unless --cache
+    size_t cache_limit;
+} Options;
+
+typedef struct {
+    int files;
+    int failed_files;
+    int unreadable;
+    long tokens;
+    int errors[3];
+    double lex_seconds;
+    double parse_seconds;
+    double exec_seconds;
+    int folded_expressions;
+    int pruned_branches;
+    int cache_hits;
+    int cache_stores;
+} Totals;
+
+// Everything one file contributes to the output, kept until it is its turn
+typedef struct {
+    OutputBuffer out;
+    OutputBuffer err;
+    Totals totals;
+    int done;
+} FileResult;
+
+// Indices of the files a worker still has to analyze. The owner takes from
+// the front of its range, idle workers steal from the back.
+typedef struct {
+    pthread_mutex_t lock;
+    int head;
+    int tail;
+} WorkQueue;
+
+typedef struct {
+    const PathList *inputs;
+    const Options *options;
+    const AnalysisCache *cache;  // NULL when caching is off
+    FileResult *results;
+    WorkQueue *queues;
+    int worker_count;
+    int lex_threads;
+    pthread_mutex_t done_lock;
+    pthread_cond_t done_cond;
+} Batch;
+
+typedef struct {
+    Batch *batch;
+    int id;
+    CompilationContext context;  // reused for every file this worker takes
+} Worker;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void add_path(PathList *list, const char *path) {
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->paths = realloc(list->paths, sizeof(char *) * list->capacity);
+    }
+    list->paths[list->count] = malloc(strlen(path) + 1);
+    strcpy(list->paths[list->count], path);
+    list->count++;
+}
+
+static void free_path_list(PathList *list) {
+    for (int i = 0; i < list->count; i++) {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    list->paths = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int has_frg_extension(const char *name) {
+    size_t len = strlen(name);
+    if (len < 4) {
+        return 0;
+    }
+    const char *ext = name + len - 4;
+    return ext[0] == '.'
+        && tolower((unsigned char)ext[1]) == 'f'
+        && tolower((unsigned char)ext[2]) == 'r'
+        && tolower((unsigned char)ext[3]) == 'g';
+}
+
+static int is_directory(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return 0;
+    }
+    return S_ISDIR(st.st_mode);
+}
+
+// Recursively collect every *.frg file below a directory.
+static void collect_directory(PathList *list, const char *dir_path) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        fprintf(stderr, "frogc: cannot open directory %s\n", dir_path);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        size_t len = strlen(dir_path) + strlen(entry->d_name) + 2;
+        char *child = malloc(len);
+        snprintf(child, len, "%s/%s", dir_path, entry->d_name);
+
+        if (is_directory(child)) {
+            collect_directory(list, child);
+        } else if (has_frg_extension(entry->d_name)) {
+            add_path(list, child);
+        }
+        free(child);
+    }
+    closedir(dir);
+}
+
+// Read one path per line from a list file (used as "@files.txt").
+static void collect_list_file(PathList *list, const char *list_path) {
+    FILE *f = fopen(list_path, "r");
+    if (!f) {
+        fprintf(stderr, "frogc: cannot open list file %s\n", list_path);
+        return;
+    }
+
+    char line[4096];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (len > 0) {
+            add_path(list, line);
+        }
+    }
+    fclose(f);
+}
+
+static const char *error_type_name(ErrorType type) {
+    switch (type) {
+        case SYNTAX_ERR: return "Syntax";
+        case LEXICAL_ERR: return "Lexical";
+        case SEMANTIC_ERR: return "Semantic";
+    }
+    return "";
+}
+
+// lex_threads > 1 splits the file itself across threads, used when there are
+// fewer files than jobs
+static void analyze_file(const char *path, const Options *options, const AnalysisCache *cache,
+                         int lex_threads, CompilationContext *context, FileResult *result) {
+    Totals *totals = &result->totals;
+    totals->files++;
+
+    SourceFile source;
+    if (!load_source_file(path, &source)) {
+        output_buffer_printf(&result->err, "%s: error: cannot open file\n", path);
+        totals->unreadable++;
+        totals->failed_files++;
+        return;
+    }
+
+    reset_compilation_context(context, source.length);
+    TokenList *tokenList = &context->tokenList;
+    ErrorList *errorList = &context->errorList;
+    SymbolTable *symbolTable = &context->symbolTable;
+    Ast *ast = &context->ast;
+    OutputBuffer *output = &context->output;
+
+    double start = now_seconds();
+    unsigned long long hash = 0;
+    CacheEntry entry;
+    int hit = 0;
+    if (cache != NULL) {
+        hash = hash_content(source.data, source.length);
+        hit = load_cache_entry(cache, hash, source.length, &entry);
+    }
+
+    // without -O or --output the cached diagnostics are all a run needs
+    int needs_ast = options->stage != STAGE_LEX && (options->optimize || options->print_output);
+    if (hit && !needs_ast) {
+        totals->cache_hits++;
+        cached_line_map(&entry, &tokenList->lines);
+        cached_errors(&entry, errorList, 0);
+        totals->tokens += entry.header->token_count;
+        totals->lex_seconds += now_seconds() - start;
+    } else {
+        // an entry whose tokens are rejected is a miss, and is stored again
+        int cached = hit && cached_tokens(&entry, tokenList);
+        if (cached) {
+            totals->cache_hits++;
+            cached_errors(&entry, errorList, 1);
+        } else {
+            lex_buffer_parallel(source.data, source.length, lex_threads, tokenList, errorList);
+        }
+        double lexed = now_seconds();
+        totals->lex_seconds += lexed - start;
+        totals->tokens += tokenList->count;
+
+        if (options->stage != STAGE_LEX) {
+            Parser parser;
+            init_parser(&parser, tokenList, symbolTable, errorList, ast);
+            parse(&parser);
+            int front_end_errors = errorList->count;  // runtime errors come after these
+            if (options->optimize) {
+                OptimizationReport *report = &context->optimization;
+                optimize_program(ast, report);
+                totals->folded_expressions += report->folded_expressions;
+                totals->pruned_branches += report->pruned_branches + report->unrolled_repeats;
+                if (!options->quiet && report->log.length > 0) {
+                    output_buffer_printf(&result->out, "%s: optimized:\n", path);
+                    output_buffer_append(&result->out, report->log.data);
+                }
+            }
+            double parsed = now_seconds();
+            totals->parse_seconds += parsed - lexed;
+
+            if (options->print_output) {
+                if (options->executor == EXEC_AST) {
+                    execute_program(ast, symbolTable, errorList, &tokenList->lines, output);
+                } else {
+                    compile_program(ast, symbolTable, &context->chunk);
+                    run_chunk(&context->chunk, symbolTable, errorList, &tokenList->lines, output);
+                }
+                totals->exec_seconds += now_seconds() - parsed;
+            }
+
+            if (cache != NULL && !cached) {
+                totals->cache_stores += store_cache_entry(cache, hash, source.length, tokenList, errorList,
+                                                          front_end_errors);
+            }
+        }
+    }
+
+    int reported = 0;
+    int line_hint = 0;
+    for (int i = 0; i < errorList->count; i++) {
+        Error *err = &errorList->errors[i];
+        // a cached run has the errors of every pass, whatever the stage
+        if ((options->stage == STAGE_LEX && err->type != LEXICAL_ERR)
+            || (options->stage == STAGE_SYNTAX && err->type == SEMANTIC_ERR)) {
+            continue;
+        }
+        totals->errors[err->type]++;
+        reported++;
+        if (!options->quiet) {
+            int line = source_line(&tokenList->lines, err->offset, &line_hint);
+            output_buffer_printf(&result->out, "%s:%d:%d: error (%s): %s\n", path, line,
+                                 source_column(&tokenList->lines, err->offset, line),
+                                 error_type_name(err->type), err->err_message);
+        }
+    }
+    if (reported > 0) {
+        totals->failed_files++;
+    }
+
+    if (options->print_output && output->length > 0) {
+        output_buffer_printf(&result->out, "%s: output:\n", path);
+        output_buffer_append(&result->out, output->data);
+        if (output->data[output->length - 1] != '\n') {
+            output_buffer_append(&result->out, "\n");
+        }
+    }
+
+    if (hit) {
+        release_cache_entry(&entry);
+    }
+    free_source_file(&source);
+}
+
+static void add_totals(Totals *into, const Totals *from) {
+    into->files += from->files;
+    into->failed_files += from->failed_files;
+    into->unreadable += from->unreadable;
+    into->tokens += from->tokens;
+    for (int i = 0; i < 3; i++) {
+        into->errors[i] += from->errors[i];
+    }
+    into->lex_seconds += from->lex_seconds;
+    into->parse_seconds += from->parse_seconds;
+    into->exec_seconds += from->exec_seconds;
+    into->folded_expressions += from->folded_expressions;
+    into->pruned_branches += from->pruned_branches;
+    into->cache_hits += from->cache_hits;
+    into->cache_stores += from->cache_stores;
+}
+
+// Next file for worker `id`: its own queue first, then the back of the others
+static int take_work(Batch *batch, int id) {
+    WorkQueue *own = &batch->queues[id];
+    pthread_mutex_lock(&own->lock);
+    int index = own->head < own->tail ? own->head++ : -1;
+    pthread_mutex_unlock(&own->lock);
+
+    for (int k = 1; index < 0 && k < batch->worker_count; k++) {
+        WorkQueue *victim = &batch->queues[(id + k) % batch->worker_count];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->head < victim->tail) {
+            index = --victim->tail;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return index;
+}
+
+static void *run_worker(void *data) {
+    Worker *worker = (Worker *)data;
+    Batch *batch = worker->batch;
+
+    int index;
+    while ((index = take_work(batch, worker->id)) >= 0) {
+        FileResult *result = &batch->results[index];
+        analyze_file(batch->inputs->paths[index], batch->options, batch->cache, batch->lex_threads,
+                     &worker->context, result);
+
+        pthread_mutex_lock(&batch->done_lock);
+        result->done = 1;
+        pthread_cond_signal(&batch->done_cond);
+        pthread_mutex_unlock(&batch->done_lock);
+    }
+    return NULL;
+}
+
+// Analyzes every input on options->jobs threads while this thread prints the
+// finished files in input order and adds up their totals
+static void analyze_batch(const PathList *inputs, const Options *options, const AnalysisCache *cache,
+                          Totals *totals) {
+    Batch batch;
+    batch.inputs = inputs;
+    batch.options = options;
+    batch.cache = cache;
+    batch.worker_count = options->jobs < inputs->count ? options->jobs : inputs->count;
+    batch.lex_threads = options->jobs / batch.worker_count;
+    batch.results = calloc((size_t)inputs->count, sizeof(FileResult));
+    batch.queues = calloc((size_t)batch.worker_count, sizeof(WorkQueue));
+    pthread_mutex_init(&batch.done_lock, NULL);
+    pthread_cond_init(&batch.done_cond, NULL);
+
+    for (int i = 0; i < inputs->count; i++) {
+        init_output_buffer(&batch.results[i].out);
+        init_output_buffer(&batch.results[i].err);
+    }
+    // contiguous ranges, so a worker's own files are next to each other
+    for (int w = 0; w < batch.worker_count; w++) {
+        pthread_mutex_init(&batch.queues[w].lock, NULL);
+        batch.queues[w].head = (int)((long long)inputs->count * w / batch.worker_count);
+        batch.queues[w].tail = (int)((long long)inputs->count * (w + 1) / batch.worker_count);
+    }
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * (size_t)batch.worker_count);
+    Worker *workers = malloc(sizeof(Worker) * (size_t)batch.worker_count);
+    int *started = calloc((size_t)batch.worker_count, sizeof(int));
+    int running = 0;
+    for (int w = 0; w < batch.worker_count; w++) {
+        workers[w].batch = &batch;
+        workers[w].id = w;
+        init_compilation_context(&workers[w].context);
+        started[w] = pthread_create(&threads[w], NULL, run_worker, &workers[w]) == 0;
+        running += started[w];
+    }
+    // the workers that did start steal the queues of those that did not; with
+    // none at all, this thread analyzes every file before printing
+    if (running == 0) {
+        run_worker(&workers[0]);
+    }
+
+    for (int i = 0; i < inputs->count; i++) {
+        FileResult *result = &batch.results[i];
+        pthread_mutex_lock(&batch.done_lock);
+        while (!result->done) {
+            pthread_cond_wait(&batch.done_cond, &batch.done_lock);
+        }
+        pthread_mutex_unlock(&batch.done_lock);
+
+        if (result->out.length > 0) {
+            fwrite(result->out.data, 1, result->out.length, stdout);
+            fflush(stdout);
+        }
+        if (result->err.length > 0) {
+            fwrite(result->err.data, 1, result->err.length, stderr);
+        }
+        add_totals(totals, &result->totals);
+        free_output_buffer(&result->out);
+        free_output_buffer(&result->err);
+    }
+
+    // idle workers may still be looking at every queue until they all exit
+    for (int w = 0; w < batch.worker_count; w++) {
+        if (started[w]) {
+            pthread_join(threads[w], NULL);
+        }
+    }
+    for (int w = 0; w < batch.worker_count; w++) {
+        pthread_mutex_destroy(&batch.queues[w].lock);
+        free_compilation_context(&workers[w].context);
+    }
+    pthread_mutex_destroy(&batch.done_lock);
+    pthread_cond_destroy(&batch.done_cond);
+    free(started);
+    free(workers);
+    free(threads);
+    free(batch.queues);
+    free(batch.results);
+}
+
+// Entries are only valid for the build that wrote them, so the cache is
+// keyed by a hash of this executable
+static void compiler_identity(char *identity, size_t size) {
+    SourceFile self;
+    if (load_source_file("/proc/self/exe", &self) && self.length > 0) {
+        snprintf(identity, size, "frogc %016llx", hash_content(self.data, self.length));
+        free_source_file(&self);
+    } else {
+        snprintf(identity, size, "frogc %s %s", __DATE__, __TIME__);
+    }
+}
+
+static void print_usage(FILE *out) {
+    fprintf(out,
+        "Usage: frogc [options] <file.frg | directory | @list.txt>...\n"
+        "\n"
+        "Options:\n"
+        "  --stage=lex|syntax|semantic  last pass to run (default: semantic)\n"
+        "  --output                     run each program and print its FRG_Print output\n"
+        "  -O, --optimize               fold constants and prune constant If/Repeat branches\n"
+        "  --exec=vm|ast                executor used by --output (default: vm)\n"
+        "  -j N, --jobs=N               analyze N files at a time (default: one per CPU)\n"
+        "  --cache[=DIR]                reuse the tokens and diagnostics of files seen before,\n"
+        "                               kept in DIR (default: " CACHE_DIRECTORY ")\n"
+        "  --cache-size=MB              evict least recently used entries above MB (default: 64)\n"
+        "  -q, --quiet                  only print the summary\n"
+        "  -h, --help                   show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    Options options = {STAGE_SEMANTIC, 0, 0, 0, EXEC_VM, cpus > 0 ? (int)cpus : 1, NULL, CACHE_DEFAULT_LIMIT};
+    PathList inputs = {NULL, 0, 0};
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(stdout);
+            free_path_list(&inputs);
+            return 0;
+        } else if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quiet") == 0) {
+            options.quiet = 1;
+        } else if (strcmp(arg, "--output") == 0) {
+            options.print_output = 1;
+        } else if (strcmp(arg, "-O") == 0 || strcmp(arg, "--optimize") == 0) {
+            options.optimize = 1;
+        } else if (strcmp(arg, "--exec=vm") == 0) {
+            options.executor = EXEC_VM;
+        } else if (strcmp(arg, "--exec=ast") == 0) {
+            options.executor = EXEC_AST;
+        } else if (strcmp(arg, "-j") == 0 || strncmp(arg, "--jobs=", 7) == 0 || (strncmp(arg, "-j", 2) == 0 && isdigit((unsigned char)arg[2]))) {
+            const char *count = NULL;
+            if (strcmp(arg, "-j") == 0) {
+                count = i + 1 < argc ? argv[++i] : "";
+            } else {
+                count = arg[1] == 'j' ? arg + 2 : arg + 7;
+            }
+            options.jobs = atoi(count);
+            if (options.jobs < 1) {
+                fprintf(stderr, "frogc: invalid job count '%s'\n", count);
+                free_path_list(&inputs);
+                return 2;
+            }
+        } else if (strcmp(arg, "--cache") == 0) {
+            options.cache_directory = CACHE_DIRECTORY;
+        } else if (strncmp(arg, "--cache=", 8) == 0 && arg[8] != '\0') {
+            options.cache_directory = arg + 8;
+        } else if (strncmp(arg, "--cache-size=", 13) == 0) {
+            char *end;
+            long megabytes = strtol(arg + 13, &end, 10);
+            if (end == arg + 13 || *end != '\0' || megabytes < 0 || megabytes > 1L << 20) {
+                fprintf(stderr, "frogc: invalid cache size '%s'\n", arg + 13);
+                free_path_list(&inputs);
+                return 2;
+            }
+            options.cache_limit = (size_t)megabytes << 20;
+        } else if (strcmp(arg, "--stage=lex") == 0) {
+            options.stage = STAGE_LEX;
+        } else if (strcmp(arg, "--stage=syntax") == 0) {
+            options.stage = STAGE_SYNTAX;
+        } else if (strcmp(arg, "--stage=semantic") == 0) {
+            options.stage = STAGE_SEMANTIC;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            fprintf(stderr, "frogc: unknown option %s\n", arg);
+            print_usage(stderr);
+            free_path_list(&inputs);
+            return 2;
+        } else if (arg[0] == '@') {
+            collect_list_file(&inputs, arg + 1);
+        } else if (is_directory(arg)) {
+            PathList found = {NULL, 0, 0};
+            collect_directory(&found, arg);
+            qsort(found.paths, found.count, sizeof(char *), compare_paths);
+            for (int j = 0; j < found.count; j++) {
+                add_path(&inputs, found.paths[j]);
+            }
+            free_path_list(&found);
+        } else {
+            add_path(&inputs, arg);
+        }
+    }
+
+    if (inputs.count == 0) {
+        print_usage(stderr);
+        return 2;
+    }
+
+    Totals totals;
+    memset(&totals, 0, sizeof(totals));
+
+    AnalysisCache cache;
+    int caching = 0;
+    if (options.cache_directory != NULL) {
+        char identity[CACHE_IDENTITY_SIZE];
+        compiler_identity(identity, sizeof(identity));
+        caching = open_cache(&cache, options.cache_directory, identity, options.cache_limit);
+        if (!caching) {
+            fprintf(stderr, "frogc: cannot use cache directory %s, continuing without it\n", options.cache_directory);
+        }
+    }
+
+    double start = now_seconds();
+    analyze_batch(&inputs, &options, caching ? &cache : NULL, &totals);
+    double elapsed = now_seconds() - start;
+    if (caching) {
+        trim_cache(&cache);
+        close_cache(&cache);
+    }
+
+    int total_errors = totals.errors[LEXICAL_ERR] + totals.errors[SYNTAX_ERR] + totals.errors[SEMANTIC_ERR];
+    printf("\n%d file(s), %d with errors, %d unreadable\n", totals.files, totals.failed_files, totals.unreadable);
+    printf("%ld token(s), %d error(s): %d lexical, %d syntax, %d semantic\n",
+           totals.tokens, total_errors,
+           totals.errors[LEXICAL_ERR], totals.errors[SYNTAX_ERR], totals.errors[SEMANTIC_ERR]);
+    if (options.optimize) {
+        printf("optimizer: %d constant operation(s) folded, %d branch(es) removed\n",
+               totals.folded_expressions, totals.pruned_branches);
+    }
+    if (caching) {
+        printf("cache: %d hit(s), %d stored\n", totals.cache_hits, totals.cache_stores);
+    }
+    // per-pass times are added up over all jobs; total is wall clock
+    printf("time: lex %.3f ms, parse %.3f ms, exec %.3f ms, total %.3f ms (%.0f files/s, %d job(s))\n",
+           totals.lex_seconds * 1e3, totals.parse_seconds * 1e3, totals.exec_seconds * 1e3, elapsed * 1e3,
+           elapsed > 0 ? totals.files / elapsed : 0.0, options.jobs);
+
+    free_path_list(&inputs);
+    return totals.failed_files > 0 ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+#include <gtk/gtk.h>
+#include "table_model.h"
+#include "../include/report.h"
+
+#define TABLE_COLUMNS 3
+
+typedef struct {
+    const char *title;
+    GType type;
+    gint width;
+} TableColumn;
+
+static const TableColumn table_columns[][TABLE_COLUMNS] = {
+    [TABLE_TOKENS] = {{"Line", G_TYPE_INT, 60}, {"Type", G_TYPE_STRING, 180}, {"Value", G_TYPE_STRING, 240}},
+    [TABLE_SYMBOLS] = {{"Name", G_TYPE_STRING, 160}, {"Type", G_TYPE_STRING, 100}, {"Value", G_TYPE_STRING, 220}},
+    [TABLE_ERRORS] = {{"Line:Col", G_TYPE_STRING, 70}, {"Kind", G_TYPE_STRING, 90}, {"Message", G_TYPE_STRING, 400}},
+};
+
+typedef struct {
+    GObject parent_instance;
+    const Analysis *analysis;
+    TableKind kind;
+    gint stamp;
+    int line_hint;  // line map index of the last row drawn
+} TableModel;
+
+typedef struct {
+    GObjectClass parent_class;
+} TableModelClass;
+
+static void table_model_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(TableModel, table_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, table_model_tree_model_init))
+
+#define TABLE_MODEL(obj) ((TableModel *)(obj))
+
+static gint row_count(const TableModel *model) {
+    switch (model->kind) {
+        case TABLE_TOKENS: return model->analysis->tokenList.count;
+        case TABLE_SYMBOLS: return model->analysis->symbolTable.count;
+        case TABLE_ERRORS: return model->analysis->errorList.count;
+    }
+    return 0;
+}
+
+static gboolean set_row(TableModel *model, GtkTreeIter *iter, gint row) {
+    if (row < 0 || row >= row_count(model)) {
+        iter->stamp = 0;
+        return FALSE;
+    }
+    iter->stamp = model->stamp;
+    iter->user_data = GINT_TO_POINTER(row);
+    return TRUE;
+}
+
+// Source text may hold bytes that are not UTF-8; GTK only renders valid text
+static void set_text(GValue *value, const char *text) {
+    if (g_utf8_validate(text, -1, NULL)) {
+        g_value_set_string(value, text);
+    } else {
+        g_value_take_string(value, g_utf8_make_valid(text, -1));
+    }
+}
+
+static GtkTreeModelFlags table_model_get_flags(GtkTreeModel *tree_model) {
+    return GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST;
+}
+
+static gint table_model_get_n_columns(GtkTreeModel *tree_model) {
+    return TABLE_COLUMNS;
+}
+
+static GType table_model_get_column_type(GtkTreeModel *tree_model, gint column) {
+    return table_columns[TABLE_MODEL(tree_model)->kind][column].type;
+}
+
+static gboolean table_model_get_iter(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreePath *path) {
+    if (gtk_tree_path_get_depth(path) != 1) {
+        return FALSE;
+    }
+    return set_row(TABLE_MODEL(tree_model), iter, gtk_tree_path_get_indices(path)[0]);
+}
+
+static GtkTreePath *table_model_get_path(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return gtk_tree_path_new_from_indices(GPOINTER_TO_INT(iter->user_data), -1);
+}
+
+static void table_model_get_value(GtkTreeModel *tree_model, GtkTreeIter *iter, gint column, GValue *value) {
+    TableModel *model = TABLE_MODEL(tree_model);
+    gint row = GPOINTER_TO_INT(iter->user_data);
+    g_value_init(value, table_columns[model->kind][column].type);
+
+    switch (model->kind) {
+        case TABLE_TOKENS: {
+            const TokenList *tokens = &model->analysis->tokenList;
+            if (column == 0) {
+                g_value_set_int(value, token_line(tokens, row, &model->line_hint));
+            } else if (column == 1) {
+                g_value_set_string(value, token_type_name(token_kind(tokens, row)));
+            } else {
+                set_text(value, token_text(tokens, row));
+            }
+            break;
+        }
+        case TABLE_SYMBOLS: {
+            const Symbol *sym = &model->analysis->symbolTable.symbols[row];
+            if (column == 0) {
+                set_text(value, sym->id);
+            } else if (column == 1) {
+                g_value_set_string(value, symbol_type_name(sym->type));
+            } else {
+                char value_text[64];
+                const char *text = format_value(&sym->value, value_text, sizeof(value_text));
+                set_text(value, text ? text : "uninitialized");
+            }
+            break;
+        }
+        case TABLE_ERRORS: {
+            const Error *err = &model->analysis->errorList.errors[row];
+            if (column == 0) {
+                const LineMap *lines = &model->analysis->tokenList.lines;
+                int line = source_line(lines, err->offset, &model->line_hint);
+                g_value_take_string(value, g_strdup_printf("%d:%d", line, source_column(lines, err->offset, line)));
+            } else if (column == 1) {
+                g_value_set_string(value, error_kind_name(err->type));
+            } else {
+                set_text(value, err->err_message);
+            }
+            break;
+        }
+    }
+}
+
+static gboolean table_model_iter_next(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return set_row(TABLE_MODEL(tree_model), iter, GPOINTER_TO_INT(iter->user_data) + 1);
+}
+
+static gboolean table_model_iter_previous(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return set_row(TABLE_MODEL(tree_model), iter, GPOINTER_TO_INT(iter->user_data) - 1);
+}
+
+static gboolean table_model_iter_nth_child(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *parent, gint n) {
+    if (parent) {
+        return FALSE;
+    }
+    return set_row(TABLE_MODEL(tree_model), iter, n);
+}
+
+static gboolean table_model_iter_children(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *parent) {
+    return table_model_iter_nth_child(tree_model, iter, parent, 0);
+}
+
+static gboolean table_model_iter_has_child(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return FALSE;
+}
+
+static gint table_model_iter_n_children(GtkTreeModel *tree_model, GtkTreeIter *iter) {
+    return iter ? 0 : row_count(TABLE_MODEL(tree_model));
+}
+
+static gboolean table_model_iter_parent(GtkTreeModel *tree_model, GtkTreeIter *iter, GtkTreeIter *child) {
+    return FALSE;
+}
+
+static void table_model_tree_model_init(GtkTreeModelIface *iface) {
+    iface->get_flags = table_model_get_flags;
+    iface->get_n_columns = table_model_get_n_columns;
+    iface->get_column_type = table_model_get_column_type;
+    iface->get_iter = table_model_get_iter;
+    iface->get_path = table_model_get_path;
+    iface->get_value = table_model_get_value;
+    iface->iter_next = table_model_iter_next;
+    iface->iter_previous = table_model_iter_previous;
+    iface->iter_children = table_model_iter_children;
+    iface->iter_has_child = table_model_iter_has_child;
+    iface->iter_n_children = table_model_iter_n_children;
+    iface->iter_nth_child = table_model_iter_nth_child;
+    iface->iter_parent = table_model_iter_parent;
+}
+
+static void table_model_init(TableModel *model) {
+    model->stamp = (gint)g_random_int();
+}
+
+static void table_model_class_init(TableModelClass *klass) {
+}
+
+GtkTreeModel *table_model_new(const Analysis *analysis, TableKind kind) {
+    TableModel *model = g_object_new(table_model_get_type(), NULL);
+    model->analysis = analysis;
+    model->kind = kind;
+    return GTK_TREE_MODEL(model);
+}
+
+// Fixed-height rows and fixed-width columns let GtkTreeView lay out only the
+// rows that are actually on screen
+GtkWidget *create_table_view(TableKind kind) {
+    GtkWidget *view = gtk_tree_view_new();
+    for (int i = 0; i < TABLE_COLUMNS; i++) {
+        const TableColumn *column = &table_columns[kind][i];
+        gtk_tree_view_insert_column_with_attributes(GTK_TREE_VIEW(view), -1, column->title,
+                                                    gtk_cell_renderer_text_new(), "text", i, NULL);
+        GtkTreeViewColumn *tree_column = gtk_tree_view_get_column(GTK_TREE_VIEW(view), i);
+        gtk_tree_view_column_set_sizing(tree_column, GTK_TREE_VIEW_COLUMN_FIXED);
+        gtk_tree_view_column_set_fixed_width(tree_column, column->width);
+    }
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(view), TRUE);
+    return view;
+}
+
+void set_table_analysis(GtkWidget *view, TableKind kind, const Analysis *analysis) {
+    if (!analysis) {
+        gtk_tree_view_set_model(GTK_TREE_VIEW(view), NULL);
+        return;
+    }
+    GtkTreeModel *model = table_model_new(analysis, kind);
+    gtk_tree_view_set_model(GTK_TREE_VIEW(view), model);
+    g_object_unref(model);
+}
@@ -0,0 +1,22 @@
+#ifndef TABLE_MODEL_H
+#define TABLE_MODEL_H
+
+#include <gtk/gtk.h>
+#include "../include/analysis.h"
+
+// GtkTreeModel that reads rows straight out of an Analysis; cells are
+// formatted only when GTK asks for a visible row.
+
+typedef enum {
+    TABLE_TOKENS,
+    TABLE_SYMBOLS,
+    TABLE_ERRORS
+} TableKind;
+
+GtkTreeModel *table_model_new(const Analysis *analysis, TableKind kind);
+
+GtkWidget *create_table_view(TableKind kind);
+// The model does not own the analysis; detach (NULL) before freeing it
+void set_table_analysis(GtkWidget *view, TableKind kind, const Analysis *analysis);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stddef.h>
+#include "token.h"
+#include "error.h"
+#include "symbol.h"
+#include "ast.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "bytecode.h"
+
+//everything the three analysis views need, produced by one pipeline run
+typedef struct {
+    TokenList tokenList;
+    ErrorList errorList;
+    SymbolTable symbolTable;
+    Ast ast;
+    OptimizationReport optimization;
+    Chunk chunk;            //bytecode of the run, kept for its capacity
+    OutputBuffer output;    //what the program printed
+    size_t content_length;
+} Analysis;
+
+//polled between passes; a nonzero return abandons the analysis
+typedef int (*CancelCheck)(void *data);
+
+Analysis *new_analysis(void);
+int run_analysis(Analysis *analysis, const char *data, size_t length, CancelCheck cancelled, void *cancel_data);
+Analysis *analyze_source(const char *data, size_t length, CancelCheck cancelled, void *cancel_data);
+void free_analysis(Analysis *analysis);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+//Bump allocator for data that lives as long as one compilation. Nothing is
+//freed on its own: arena_reset drops everything at once and keeps the
+//blocks for the next run, arena_rewind drops everything allocated after a
+//given pointer.
+typedef struct {
+    ArenaBlock *blocks;     //newest first, only the newest has room left
+    ArenaBlock *oldest;     //last of blocks, so a reset is O(1)
+    ArenaBlock *spare;      //emptied blocks waiting to be reused
+} Arena;
+
+void *arena_alloc(Arena *arena, size_t size);
+char *arena_strdup(Arena *arena, const char *text);
+char *arena_strndup(Arena *arena, const char *text, size_t length);
+void arena_rewind(Arena *arena, const void *position);
+void arena_reset(Arena *arena);
+void arena_merge(Arena *into, Arena *from);
+size_t arena_bytes(const Arena *arena);
+void arena_free(Arena *arena);
+
+#endif
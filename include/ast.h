@@ -0,0 +1,76 @@
+#ifndef AST_H
+#define AST_H
+
+#include "token.h"
+#include "symbol.h"
+
+//executors stop a Repeat loop with an error after this many iterations
+#define MAX_REPEAT_ITERATIONS 1000000
+
+typedef enum {
+    AST_PROGRAM,        //children: statements
+    AST_BLOCK,          //children: statements
+    AST_DECLARATION,    //children: AST_ASSIGN initializers
+    AST_ASSIGN,         //symbol := left
+    AST_PRINT,          //children: printed expressions
+    AST_IF,             //If left then right Else extra
+    AST_REPEAT,         //children: body, left: until condition
+    AST_CONDITION,      //left op right, op is a Relation
+    AST_INT_LITERAL,
+    AST_REAL_LITERAL,
+    AST_STRING_LITERAL,
+    AST_VARIABLE,       //symbol
+    AST_NEGATE,         //-left
+    AST_BINARY          //left op right, op is an OPERATOR_* token type
+} AstKind;
+
+typedef enum {
+    REL_LT,
+    REL_LE,
+    REL_GT,
+    REL_GE,
+    REL_EQ,
+    REL_NE
+} Relation;
+
+//nodes refer to each other by index into Ast.nodes, -1 when absent
+typedef struct {
+    AstKind kind;
+    int line;
+    SymbolType type;    //inferred type of expression nodes
+    int op;
+    int symbol;         //position in the SymbolTable, -1 if undeclared
+    int left;
+    int right;
+    int extra;
+    int first_child;    //lists live contiguously in Ast.children
+    int child_count;
+    union {
+        long long integer;
+        double number;
+        const char *text;   //interned in the TokenList's pool
+    } literal;
+} AstNode;
+
+typedef struct {
+    AstNode *nodes;
+    int count;
+    int capacity;
+    int *children;
+    int child_count;
+    int child_capacity;
+    int *scratch;       //items of lists still being parsed
+    int scratch_count;
+    int scratch_capacity;
+    int root;
+} Ast;
+
+void init_ast(Ast *ast);
+int ast_add_node(Ast *ast, AstKind kind, int line);
+int ast_list_mark(Ast *ast);
+void ast_list_push(Ast *ast, int node);
+void ast_list_finish(Ast *ast, int parent, int mark);
+void clear_ast(Ast *ast);
+void free_ast(Ast *ast);
+
+#endif
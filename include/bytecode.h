@@ -0,0 +1,62 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "ast.h"
+#include "symbol.h"
+#include "error.h"
+#include "parser.h"
+
+typedef enum {
+    OP_CONST,           //push constants[a]
+    OP_UNDEF,           //push an undefined value
+    OP_LOAD,            //push slots[a]
+    OP_STORE,           //pop into slots[a]
+    OP_STORE_REAL,      //pop into slots[a], widening integers to real
+    OP_POP,
+    OP_NEG,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_COMPARE,         //pop rhs, lhs; push 1/0, or undefined, for Relation a
+    OP_PRINT,           //pop a values and print them on one line
+    OP_JUMP,            //goto a
+    OP_BRANCH,          //pop condition; false: goto a, undefined: goto b
+    OP_REPEAT_ENTER,    //reset loop counter a
+    OP_REPEAT_BACK,     //pop condition; false: count loop a and goto b
+    OP_HALT
+} OpCode;
+
+typedef struct {
+    unsigned char op;
+    int a;
+    int b;
+} Instruction;
+
+typedef struct {
+    Instruction *code;
+    int *lines;             //source line of each instruction, for runtime errors
+    int count;
+    int capacity;
+    Value *constants;
+    int constant_count;
+    int constant_capacity;
+    int slot_count;         //one slot per symbol
+    int loop_count;
+    int max_stack;
+    Value *slots;           //run_chunk's scratch, kept for the next run
+    Value *stack;
+    long *loops;
+    int slot_capacity;
+    int stack_capacity;
+    int loop_capacity;
+} Chunk;
+
+void init_chunk(Chunk *chunk);
+void clear_chunk(Chunk *chunk);
+void free_chunk(Chunk *chunk);
+void compile_program(const Ast *ast, const SymbolTable *symbolTable, Chunk *chunk);
+//lines locates runtime errors, which only know the line of their instruction
+void run_chunk(Chunk *chunk, SymbolTable *symbolTable, ErrorList *errors, const LineMap *lines, OutputBuffer *output);
+
+#endif
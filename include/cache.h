@@ -0,0 +1,112 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include "token.h"
+#include "error.h"
+
+//On-disk cache of what the front end makes of a source file: its token
+//stream, line map and diagnostics, so an unchanged file is neither lexed
+//nor parsed again. One entry per file content lives in the
+//cache directory as <content hash>.frgc, written in a layout that is used
+//straight from a mapping of the file once it has been validated.
+//
+//An entry is only trusted when everything it was derived from matches:
+// - the file name is the hash of the source bytes, and the header repeats
+//   the hash and the length, so an edited source misses;
+// - the header names the compiler that wrote it (the cache's identity), so
+//   a rebuilt frogc ignores entries of the old one and overwrites them;
+// - a wrong magic or format number, a size that is not the file's, a body
+//   that does not hash to the header's checksum, a section that does not
+//   fit or an offset past the source is a miss too, and the entry is
+//   rewritten.
+//Entries are touched on every hit; trim_cache deletes the least recently
+//used ones until the directory fits in its limit again.
+
+#define CACHE_FORMAT 3
+#define CACHE_DIRECTORY ".frgcache"
+#define CACHE_DEFAULT_LIMIT (64u << 20)
+#define CACHE_IDENTITY_SIZE 48
+
+typedef struct {
+    char *directory;
+    char identity[CACHE_IDENTITY_SIZE];    //compiler the entries must come from
+    size_t limit;                           //bytes the directory may hold after trim_cache
+} AnalysisCache;
+
+//an entry file starts with this header; every section is 8 byte aligned and
+//located by its offset from the start of the file
+typedef struct {
+    char magic[8];                  //"FRGCACHE"
+    unsigned int format;            //CACHE_FORMAT
+    unsigned int size;              //bytes in the whole entry
+    char identity[CACHE_IDENTITY_SIZE];
+    unsigned long long content_hash;
+    unsigned long long content_length;
+    unsigned long long body_hash;   //hash_content of everything after the header
+    unsigned int token_count;       //kinds and offsets
+    unsigned int text_count;        //pool ids of the tokens with text
+    unsigned int line_count;
+    unsigned int string_count;      //the pool, by id
+    unsigned int error_count;
+    unsigned int kinds;
+    unsigned int offsets;
+    unsigned int texts;
+    unsigned int lines;
+    unsigned int strings;
+    unsigned int errors;
+    unsigned int blob;              //NUL terminated strings the sections above point into
+    unsigned int blob_size;
+    unsigned int reserved;
+} CacheHeader;
+
+typedef struct {
+    unsigned int type;      //ErrorType
+    unsigned int offset;
+    unsigned int message;   //blob offset
+} CachedError;
+
+//a validated entry, its sections pointing into the mapped file
+typedef struct {
+    SourceFile file;
+    const CacheHeader *header;
+    const unsigned char *kinds;
+    const unsigned int *offsets;
+    const int *texts;
+    const unsigned int *lines;
+    const unsigned int *strings;    //blob offset of every pool string
+    const CachedError *errors;
+    const char *blob;
+} CacheEntry;
+
+unsigned long long hash_content(const char *data, size_t length);
+
+//creates the directory if needed; returns 0 if it cannot be used
+int open_cache(AnalysisCache *cache, const char *directory, const char *identity, size_t limit);
+void close_cache(AnalysisCache *cache);
+
+//maps and validates the entry of a source with the given hash and length;
+//returns 0 on a miss, and removes an entry that failed validation
+int load_cache_entry(const AnalysisCache *cache, unsigned long long hash, size_t length, CacheEntry *entry);
+void release_cache_entry(CacheEntry *entry);
+
+//refill an empty token list, line map or error list from an entry.
+//cached_tokens also fills the list's line map; it returns 0 if the entry
+//does not describe a token list this build could have made, and leaves
+//the list empty to be lexed again. lexical_only keeps just the errors the
+//lexer would have reported, for tokens that are about to be parsed again.
+int cached_tokens(const CacheEntry *entry, TokenList *tokens);
+void cached_line_map(const CacheEntry *entry, LineMap *lines);
+void cached_errors(const CacheEntry *entry, ErrorList *errors, int lexical_only);
+
+//writes the entry of a parsed source; error_count limits it to the first
+//errors, those of the lexer and parser. The file appears atomically, so
+//concurrent runs sharing a directory never see half an entry.
+int store_cache_entry(const AnalysisCache *cache, unsigned long long hash, size_t length,
+                      const TokenList *tokens, const ErrorList *errors, int error_count);
+
+//deletes least recently used entries, and stale temporary files, until the
+//directory holds at most cache->limit bytes
+void trim_cache(const AnalysisCache *cache);
+
+#endif
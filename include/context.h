@@ -0,0 +1,32 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <stddef.h>
+#include "token.h"
+#include "error.h"
+#include "symbol.h"
+#include "ast.h"
+#include "parser.h"
+#include "optimizer.h"
+#include "bytecode.h"
+
+//Everything one compilation fills in, owned together so it can be reused:
+//a reset empties the lists but keeps their memory, so compiling file after
+//file stops allocating once the largest one has been seen.
+typedef struct {
+    TokenList tokenList;
+    ErrorList errorList;
+    SymbolTable symbolTable;
+    Ast ast;
+    OptimizationReport optimization;
+    Chunk chunk;
+    OutputBuffer output;    //what the program printed
+} CompilationContext;
+
+void init_compilation_context(CompilationContext *context);
+//empties the context for a source of source_length bytes, growing the token
+//list up front to the size it will probably need
+void reset_compilation_context(CompilationContext *context, size_t source_length);
+void free_compilation_context(CompilationContext *context);
+
+#endif
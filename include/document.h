@@ -0,0 +1,43 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include <stddef.h>
+#include "token.h"
+#include "error.h"
+#include "parser.h"
+#include "analysis.h"
+
+//per-line lexing results, so an edit only re-lexes the lines it touched
+typedef struct {
+    size_t length;      //bytes, including the '\n' except on the last line
+    int token_count;
+    int error_count;    //lexical errors reported on this line
+    TokenType end_type; //lexer state after this line
+} LineInfo;
+
+//An editable source kept lexed and parsed as it changes. Lines are counted
+//like a text editor does: n newlines make n + 1 lines.
+typedef struct {
+    char *text;
+    size_t length;
+    size_t capacity;
+    LineInfo *lines;
+    int line_count;
+    int line_capacity;
+    ErrorList lexErrors;    //in line order
+    int lex_messages;       //messages in lexErrors' arena, including dropped ones
+    ErrorList parseErrors;
+    ParseLog parseLog;
+    //owns tokens, symbols and AST; errorList only views lexErrors followed by
+    //parseErrors and must not be freed with free_analysis
+    Analysis analysis;
+    int error_view_capacity;
+} Document;
+
+void init_document(Document *doc);
+void free_document(Document *doc);
+void document_set_text(Document *doc, const char *text, size_t length);
+void document_replace_lines(Document *doc, int first_line, int old_count, int new_count,
+                            const char *text, size_t length);
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef ERROR_H
 #define ERROR_H
 
+#include "arena.h"
+#include "source.h"
+
 typedef enum {
     SYNTAX_ERR,
     LEXICAL_ERR,
@@ -9,19 +12,24 @@ typedef enum {
 
 typedef struct {
     ErrorType type;
-    char *err_message;
-    int line;
+    const char *err_message;
+    unsigned int offset;    //where in the source, NO_SOURCE_OFFSET if nowhere; see source_line
+    int at_line_start;      //offset is the start of a line, not of a token
 } Error;
 
 typedef struct {
     Error *errors;
     int count;
     int capacity;
+    Arena messages;     //owns every err_message, freed all at once
 } ErrorList;
 
-Error create_error(ErrorType type, const char *message, int line);
+Error create_error(ErrorType type, const char *message, unsigned int offset);
 void add_error(ErrorList *list, Error error);
+void truncate_error_list(ErrorList *list, int count);
+void compact_error_list(ErrorList *list);
+void clear_error_list(ErrorList *list);
 void free_error_list(ErrorList *list);
-void print_errors(ErrorList *list, ErrorType type);
+void print_errors(ErrorList *list, const LineMap *lines, ErrorType type);
 
 #endif
@@ -0,0 +1,12 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "ast.h"
+#include "symbol.h"
+#include "error.h"
+#include "parser.h"
+
+//lines locates runtime errors, which only know the line of their node
+void execute_program(const Ast *ast, SymbolTable *symbolTable, ErrorList *errors, const LineMap *lines, OutputBuffer *output);
+
+#endif
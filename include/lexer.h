@@ -3,7 +3,15 @@
 
 #include "token.h"
 #include "error.h"
+#include "source.h"
+#include <stddef.h>
 
-void lexer(char *filePath, TokenList *tokenList, ErrorList *errorList);
+int lexer(char *filePath, TokenList *tokenList, ErrorList *errorList);
+TokenType keyword_type(const char *word, size_t length);
+//in-memory entry points: nothing is read from disk
+void lex_source(const SourceFile *source, TokenList *tokenList, ErrorList *errorList);
+void lex_buffer(const char *data, size_t length, TokenList *tokenList, ErrorList *errorList);
+void lex_buffer_parallel(const char *data, size_t length, int threads, TokenList *tokenList, ErrorList *errorList);
+void lex_line(const char *data, size_t offset, size_t length, TokenType *last_type, TokenList *tokenList, ErrorList *errorList);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+#include "parser.h"
+
+typedef struct {
+    int folded_expressions;     //operators replaced by their constant result
+    int pruned_branches;        //If/Else branches that can never run
+    int unrolled_repeats;       //Repeat loops whose until condition is always true
+    OutputBuffer log;           //one line per change, with its source line
+} OptimizationReport;
+
+void init_optimization_report(OptimizationReport *report);
+void clear_optimization_report(OptimizationReport *report);
+void free_optimization_report(OptimizationReport *report);
+void optimize_program(Ast *ast, OptimizationReport *report);
+
+#endif
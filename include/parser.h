@@ -5,6 +5,7 @@
 #include "token.h"
 #include "symbol.h"
 #include "error.h"
+#include "ast.h"
 
 typedef struct {
     char *data;
@@ -12,19 +13,64 @@ typedef struct {
     size_t capacity;
 } OutputBuffer;
 
+//parser state at the start of a top-level statement
+typedef struct {
+    int position;
+    int node_count;
+    int child_count;
+    int scratch_count;
+    int error_count;
+    int symbol_count;
+    int assigned_count;
+} ParseCheckpoint;
+
+struct ParseTail;
+
+//what parse_incremental needs to roll a parse back to any top-level statement
+typedef struct {
+    ParseCheckpoint *checkpoints;
+    int count;
+    int capacity;
+    int *assigned; //symbols whose assigned flag the parse set, in order
+    int assigned_count;
+    int assigned_capacity;
+    int program_mark; //scratch mark of the program's statement list
+    int dropped_messages; //error messages re-parses left in the errors' arena
+    struct ParseTail *tail; //previous results past the resume point, during a re-parse
+} ParseLog;
+
+//how the token list changed since the last parse
+typedef struct {
+    int first;       //first token that differs
+    int end;         //tokens from here on are the old ones, moved by delta
+    int delta;       //new token count minus old
+    int lines_moved; //tokens after end changed line, so old results can't be reused
+    unsigned int text_end; //old source offsets from here on moved by text_delta bytes
+    int text_delta;
+} TokenEdit;
+
 typedef struct {
     TokenList *tokens;
     int position;
     SymbolTable *symbolTable;
     ErrorList *errors;
-    OutputBuffer *output;
+    Ast *ast; //receives the program tree, executed separately by the interpreter
+    ParseLog *log; //optional, records checkpoints for incremental re-parsing
+    TokenCursor cursor; //text and line of the token at position, while it is in step
 } Parser;
 
 void init_output_buffer(OutputBuffer *buffer);
+void clear_output_buffer(OutputBuffer *buffer);
 void free_output_buffer(OutputBuffer *buffer);
 char *detach_output_buffer(OutputBuffer *buffer);
+void output_buffer_append(OutputBuffer *buffer, const char *text);
+void output_buffer_printf(OutputBuffer *buffer, const char *format, ...);
 
-void init_parser(Parser *parser, TokenList *tokens, SymbolTable *symbolTable, ErrorList *errors, OutputBuffer *output);
+void init_parser(Parser *parser, TokenList *tokens, SymbolTable *symbolTable, ErrorList *errors, Ast *ast);
 void parse(Parser *parser);
 
+void init_parse_log(ParseLog *log);
+void free_parse_log(ParseLog *log);
+void parse_incremental(Parser *parser, ParseLog *log, const TokenEdit *edit);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "analysis.h"
+#include "parser.h"
+
+const char *token_type_name(TokenType type);
+const char *symbol_type_name(SymbolType type);
+const char *error_kind_name(ErrorType type);
+
+//text reports shown by the GUI, appended to `out` without any size limit
+void write_lexical_report(const Analysis *analysis, OutputBuffer *out);
+void write_syntax_report(const Analysis *analysis, OutputBuffer *out);
+void write_semantic_report(const Analysis *analysis, OutputBuffer *out);
+void write_variables_report(const Analysis *analysis, OutputBuffer *out);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//ASCII character classes used by the lexer; unlike <ctype.h> they do not
+//depend on the C locale
+#define SCAN_ALPHA 1    //letters and '_'
+#define SCAN_DIGIT 2
+#define SCAN_BLANK 4    //' ' and '\t'
+
+extern const unsigned char scan_classes[256];
+
+static inline int scan_is(char c, int classes){
+    return scan_classes[(unsigned char)c] & classes;
+}
+
+//length of the run of `classes` bytes at the start of text, looking at most
+//length bytes and never reading past them. Runs are checked 16 (SSE2) or 32
+//(AVX2) bytes at a time.
+size_t scan_run(const char *text, size_t length, int classes);
+
+#if defined(__SSE2__)
+//the first block is tested inline, since almost every token ends inside it
+static inline size_t scan_run_inline(const char *text, size_t length, int classes){
+    if(length < 16){
+        return scan_run(text, length, classes);
+    }
+    __m128i x = _mm_loadu_si128((const __m128i *)text);
+    __m128i mask = _mm_setzero_si128();
+    if(classes & SCAN_ALPHA){
+        //setting bit 5 folds upper case onto lower case; bytes >= 0x80 are
+        //negative as signed chars and fall outside every range
+        __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        mask = _mm_or_si128(mask, _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                                _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+    }
+    if(classes & SCAN_DIGIT){
+        mask = _mm_or_si128(mask, _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)),
+                                                _mm_cmplt_epi8(x, _mm_set1_epi8('9' + 1))));
+    }
+    if(classes & SCAN_BLANK){
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+    }
+    unsigned int outside = ~(unsigned int)_mm_movemask_epi8(mask) & 0xFFFFu;
+    if(outside != 0){
+        return (size_t)__builtin_ctz(outside);
+    }
+    return 16 + scan_run(text + 16, length - 16, classes);
+}
+#else
+static inline size_t scan_run_inline(const char *text, size_t length, int classes){
+    return scan_run(text, length, classes);
+}
+#endif
+
+static inline size_t scan_identifier(const char *text, size_t length){    //letters, digits and '_'
+    return scan_run_inline(text, length, SCAN_ALPHA | SCAN_DIGIT);
+}
+
+static inline size_t scan_digits(const char *text, size_t length){
+    return scan_run_inline(text, length, SCAN_DIGIT);
+}
+
+static inline size_t scan_blanks(const char *text, size_t length){
+    return scan_run_inline(text, length, SCAN_BLANK);
+}
+
+//first occurrence of c, or NULL; same contract as memchr
+const char *scan_find(const char *text, size_t length, char c);
+
+#endif
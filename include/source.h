@@ -0,0 +1,61 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+#include <limits.h>
+
+typedef struct {
+    const char *data;   //file contents, not NUL terminated
+    size_t length;      //number of bytes in data
+    int mapped;         //1 if data is a memory mapping, 0 if heap allocated
+} SourceFile;
+
+int load_source_file(const char *path, SourceFile *source);
+//always a heap copy: for sources kept while the file may be rewritten on disk,
+//which would pull a mapping out from under them
+int read_source_file(const char *path, SourceFile *source);
+//replaces the contents with a malloc'd buffer the source then owns, e.g. the
+//file converted to another encoding
+void source_take_buffer(SourceFile *source, char *data, size_t length);
+void free_source_file(SourceFile *source);
+
+//position of a diagnostic that points nowhere in the source, e.g. an empty one
+#define NO_SOURCE_OFFSET UINT_MAX
+//offsets are 32 bit and must stay below NO_SOURCE_OFFSET, so larger sources
+//are refused by the lexer
+#define MAX_SOURCE_LENGTH ((size_t)UINT_MAX - 1)
+
+//Byte offset at which every line starts, recorded once while the lexer
+//finds the newlines. Tokens and errors only keep offsets; their lines and
+//columns are looked up here when someone displays them.
+typedef struct {
+    unsigned int *starts;   //starts[i] is where line i + 1 begins
+    int count;
+    int capacity;
+} LineMap;
+
+void add_line_start(LineMap *map, unsigned int offset);
+int line_map_search(const LineMap *map, unsigned int offset, int *line_hint);
+unsigned int line_start_offset(const LineMap *map, int line);
+int source_column(const LineMap *map, unsigned int offset, int line);
+void clear_line_map(LineMap *map);
+void free_line_map(LineMap *map);
+
+//line of offset, 0 when it has none. line_hint, if given, holds the line
+//index of the previous lookup, so a caller walking forward rarely searches.
+static inline int source_line(const LineMap *map, unsigned int offset, int *line_hint){
+    if(line_hint != NULL && offset != NO_SOURCE_OFFSET){
+        //on the hinted line or, having just crossed a newline, on the next one
+        const unsigned int *starts = map->starts;
+        int count = map->count;
+        for(int line = *line_hint; line < count && line <= *line_hint + 1 && starts[line] <= offset; line++){
+            if(line + 1 == count || starts[line + 1] > offset){
+                *line_hint = line;
+                return line + 1;
+            }
+        }
+    }
+    return line_map_search(map, offset, line_hint);
+}
+
+#endif
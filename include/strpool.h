@@ -0,0 +1,41 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stddef.h>
+#include "arena.h"
+
+typedef struct {
+    const char *text;
+    unsigned int length;
+    unsigned int hash;
+    int id;
+} StringEntry;
+
+//every string also gets a small id, numbered in interning order, so tables
+//can refer to it with 4 bytes instead of a pointer
+typedef struct {
+    Arena arena;            //strings never move once interned
+    StringEntry *entries;   //open addressing index, capacity is a power of two
+    const char **texts;     //by id
+    unsigned int *hashes;   //hash_string of each text, by id
+    int count;
+    int capacity;
+    int text_capacity;
+} StringPool;
+
+unsigned int hash_string(const char *text, size_t length);
+int intern_string_id(StringPool *pool, const char *text, size_t length);
+const char *intern_string(StringPool *pool, const char *text, size_t length);
+void merge_string_pool(StringPool *into, StringPool *from, int *remap);
+void clear_string_pool(StringPool *pool);
+void free_string_pool(StringPool *pool);
+
+static inline const char *string_pool_text(const StringPool *pool, int id){
+    return pool->texts[id];
+}
+
+static inline unsigned int string_pool_hash(const StringPool *pool, int id){
+    return pool->hashes[id];
+}
+
+#endif
@@ -2,22 +2,17 @@
 #define SYMBOL_H
 
 #include "token.h"  
+#include "value.h"
 #include <stdlib.h>
 #include <string.h>
 
-typedef  enum{
-    KEY_INT,
-    KEY_REAL,
-    KEY_STRING,
-    KEY_UNKNOWN 
-}SymbolType;
-
 
 typedef struct{
     SymbolType type;
-    char *id;
-    char *value;
+    const char *id;     //owned by the table's ids arena once added
+    Value value; //set by execution; string values point into the TokenList's pool
     int line_declared;
+    int assigned; //an assignment has been parsed, checked before reads
 }Symbol;
 
 
@@ -25,11 +20,17 @@ typedef struct{
     Symbol *symbols;
     int count;
     int capacity;
+    int *index; //open addressing hash of ids, holds symbol position + 1, 0 when empty
+    int index_capacity; //power of two, kept at least twice count
+    Arena ids;
 }SymbolTable;
 
 Symbol create_symbol(const char *name, SymbolType type, int line_declared);
 void add_symbol(SymbolTable *table, Symbol symbol);
 Symbol* findSymbol(SymbolTable *table, const char *id);
+Symbol* findSymbolHashed(SymbolTable *table, const char *id, unsigned int hash);
+void truncate_symbol_table(SymbolTable *table, int count);
+void clear_symbol_table(SymbolTable *table);
 void free_symbol_table(SymbolTable *table);
 
 #endif
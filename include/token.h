@@ -2,6 +2,9 @@
 #define TOKEN_H
 
 #include <stdio.h>
+#include <limits.h>
+#include "strpool.h"
+#include "source.h"
 
 typedef enum {
     NONE,
@@ -37,22 +40,120 @@ typedef enum {
 
 } TokenType;
 
+//one token as the parser and the views see it, assembled on demand from the
+//list's columns
 typedef struct{
     TokenType type; //type of token
-    char *value; //actuall text of the token
-    int line; //located at number line in source code
+    int line; //line of offset, looked up in the list's line map
+    unsigned int offset; //byte offset of the lexeme in the source buffer
+    const char *value; //interned text for identifiers/literals/comments/relations, static spelling otherwise
 }Token;
 
 
+//Tokens are stored column by column. Most of the parser's work is checking
+//kinds, which are packed one byte per token. Only identifiers, literals,
+//comments and relational operators have text: their pool ids are kept in
+//token order, and a token finds its own by counting the text tokens before
+//it in text_bits. Lines are not stored per token at all: the line map holds
+//where each source line starts, and a token's line is found from its offset.
 typedef struct 
 {
-    Token *tokens; //pointer to array of tokens]
+    unsigned char *kinds; //TokenType of every token
+    unsigned int *offsets; //byte offset of every lexeme
     int count; //number of tokens
-    int capacity; // capacity of the array  
+    int capacity; // capacity of the columns above
+    int *texts; //pool ids of the tokens that have text, in order
+    int text_count;
+    int text_capacity;
+    unsigned long long *text_bits; //bit i is set when token i has text
+    int *text_ranks; //text tokens before each block of 64 tokens
+    LineMap lines; //where each source line starts, recorded by the lexer
+    StringPool strings; //owns the text of identifiers, literals and comments
 } TokenList;
 
-Token create_token(TokenType type, const char *value, int line);
-void add_token(TokenList *list, Token token);
+//kinds that carry text, as a bit mask over TokenType
+#define TOKEN_TEXT_KINDS ((1u << IDENTIFIER) | (1u << INTEGER_LITERAL) | (1u << FLOAT_LITERAL) \
+                          | (1u << STRING_LITERAL) | (1u << COMMENT) | (1u << RELATIONAL_OP))
+
+const char *token_spelling(TokenType type);
+void add_token(TokenList *list, TokenType type, unsigned int offset, int text);
+void append_tokens(TokenList *list, TokenList *from, int first);
+void rotate_tokens(TokenList *list, int at, int removed, int fresh_start);
+size_t token_list_footprint(const TokenList *list);
+int estimate_token_count(size_t source_length);
+void reserve_token_list(TokenList *list, int capacity);
+void clear_token_list(TokenList *list);
 void free_token_list(TokenList *list);
 
-#endif
\ No newline at end of file
+//walks the list keeping the text and line of its token at hand, so moving
+//to the next token is all a forward scan pays for them
+typedef struct {
+    int index;
+    int text; //texts index of the token's text, if it has any
+    int line; //line map index of the token's line
+    int line_end; //first token past the token's line
+} TokenCursor;
+
+void token_cursor_seek(const TokenList *list, TokenCursor *cursor, int index);
+void token_cursor_line_end(const TokenList *list, TokenCursor *cursor);
+
+//the accessors below run for nearly every token the parser looks at, so the
+//common case is inline
+
+static inline TokenType token_kind(const TokenList *list, int index){
+    return (TokenType)list->kinds[index];
+}
+
+static inline int token_has_text(TokenType type){
+    return (TOKEN_TEXT_KINDS >> type) & 1;
+}
+
+//number of tokens with text before token index
+static inline int token_text_rank(const TokenList *list, int index){
+    if(index >= list->count){
+        return list->text_count;
+    }
+    unsigned long long below = list->text_bits[index >> 6] & ((1ULL << (index & 63)) - 1);
+    return list->text_ranks[index >> 6] + __builtin_popcountll(below);
+}
+
+//the interned text of identifiers, literals, comments and relational
+//operators, the fixed spelling of everything else
+static inline const char *token_text(const TokenList *list, int index){
+    TokenType type = token_kind(list, index);
+    if(!token_has_text(type)){
+        return token_spelling(type);
+    }
+    return string_pool_text(&list->strings, list->texts[token_text_rank(list, index)]);
+}
+
+//line of a token; line_hint as for source_line
+static inline int token_line(const TokenList *list, int index, int *line_hint){
+    return source_line(&list->lines, list->offsets[index], line_hint);
+}
+
+static inline Token get_token(const TokenList *list, int index, int *line_hint){
+    Token token;
+    token.type = token_kind(list, index);
+    token.line = token_line(list, index, line_hint);
+    token.offset = list->offsets[index];
+    token.value = token_text(list, index);
+    return token;
+}
+
+static inline void token_cursor_next(const TokenList *list, TokenCursor *cursor){
+    if(cursor->index < list->count){
+        cursor->text += token_has_text(token_kind(list, cursor->index));
+    }
+    if(++cursor->index < cursor->line_end || cursor->index >= list->count){
+        return;
+    }
+    const unsigned int *starts = list->lines.starts;
+    unsigned int offset = list->offsets[cursor->index];
+    while(cursor->line + 1 < list->lines.count && starts[cursor->line + 1] <= offset){
+        cursor->line++;
+    }
+    token_cursor_line_end(list, cursor);
+}
+
+#endif
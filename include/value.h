@@ -0,0 +1,31 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <stddef.h>
+
+typedef  enum{
+    KEY_INT,
+    KEY_REAL,
+    KEY_STRING,
+    KEY_UNKNOWN 
+}SymbolType;
+
+typedef struct {
+    SymbolType type; //KEY_UNKNOWN when the value is undefined
+    union {
+        long long i;
+        double r;
+        const char *s; //interned in the TokenList's pool
+    } as;
+} Value;
+
+Value undefined_value(void);
+Value int_value(long long i);
+Value real_value(double r);
+Value string_value(const char *s);
+int value_is_number(const Value *value);
+double value_as_real(const Value *value);
+int compare_values(const Value *lhs, const Value *rhs, int *cmp);
+const char *format_value(const Value *value, char *buffer, size_t size);
+
+#endif
@@ -6,8 +6,43 @@
 #include "include/token.h"
 #include "include/error.h"
 #include "include/symbol.h"
-#include "include/lexer.h"
-#include "include/parser.h"
+#include "include/optimizer.h"
+#include "include/analysis.h"
+#include "include/report.h"
+#include "include/document.h"
+#include "include/strpool.h"
+#include "include/source.h"
+#include "gui/table_model.h"
+
+// Reports are inserted into a GtkTextBuffer this many bytes per main loop
+// iteration, so huge listings never stall the UI in one gtk call
+#define FILL_CHUNK_SIZE (64 * 1024)
+
+typedef enum {
+    VIEW_LEXICAL,
+    VIEW_SYNTAX,
+    VIEW_SEMANTIC
+} AnalysisView;
+
+typedef struct AnalysisJob AnalysisJob;
+
+// The chosen file, read and checked for UTF-8 once. The source
+// view, the document and every analysis job work from this copy instead of
+// going back to the disk; jobs hold a reference, so choosing another file
+// never frees it under a running analysis.
+typedef struct {
+    SourceFile file;
+    gint refs;
+} LoadedSource;
+
+// Text still being streamed into a buffer from an idle callback
+typedef struct {
+    GtkTextBuffer *buffer;
+    char *text;
+    size_t length;
+    size_t offset;
+    guint source_id;
+} TextFill;
 
 // GUI Widgets
 typedef struct {
@@ -25,20 +60,77 @@ typedef struct {
     GtkTextBuffer *variables_buffer;  // New: buffer for variables
     GtkWidget *final_result_label;  
     char *current_file_path;
-    TokenList tokenList;
-    ErrorList errorList;
-    SymbolTable symbolTable;
-    char *program_output;
+    LoadedSource *source;  // NULL if the chosen file could not be read
+    Analysis *analysis;  // lexer/parser/VM results shared by all three buttons
+    char *analyzed_text;  // edited source the analysis was made from, NULL if the file
+    size_t analyzed_length;
+    Analysis *spare_analysis;  // previous results, refilled by the next job to reuse their memory
+    AnalysisJob *pending_job;  // analysis running on the worker thread, if any
+    TextFill result_fill;
+    TextFill variables_fill;
+    GtkWidget *token_view;
+    GtkWidget *symbol_view;
+    GtkWidget *error_view;
+    const Analysis *table_analysis;  // analysis the token and symbol tables read from
+    GtkWidget *diagnostics_label;
+    Document document;  // source as edited, kept lexed and parsed for live diagnostics
+    gboolean loading_source;  // buffer is being replaced by a file load, not edited
+    gboolean source_modified;  // buffer differs from the loaded file
+    int edit_first_line;  // lines replaced by the edit GTK is about to apply
+    int edit_old_count;
+    gboolean edit_pending;
+    gboolean edit_overlapped;  // a second edit started before "changed" arrived
 } AppWidgets;
 
-static void set_buffer_text_utf8(GtkTextBuffer *buffer, const char *text) {
-    if (!buffer) {
-        return;
+// One background analysis. The worker thread fills in the result and hands
+// the job back to the main loop with g_idle_add.
+struct AnalysisJob {
+    AppWidgets *widgets;
+    AnalysisView view;  // view to show when done; only touched on the main thread
+    GCancellable *cancellable;
+    LoadedSource *source;  // file to analyze, unless it has been edited
+    char *text;  // edited source to analyze instead of the file, if any
+    size_t text_length;
+    Analysis *analysis;  // the widgets' spare analysis, or NULL to allocate one
+};
+
+static LoadedSource *loaded_source_ref(LoadedSource *source) {
+    g_atomic_int_inc(&source->refs);
+    return source;
+}
+
+static void loaded_source_unref(LoadedSource *source) {
+    if (source && g_atomic_int_dec_and_test(&source->refs)) {
+        free_source_file(&source->file);
+        free(source);
     }
-    const char *src = text ? text : "";
-    char *safe = g_utf8_make_valid(src, -1);
-    gtk_text_buffer_set_text(buffer, safe, -1);
-    g_free(safe);
+}
+
+// Read the file once; text that is not valid UTF-8 is converted from the
+// locale's encoding, or repaired, so the view can show it as is
+static LoadedSource *load_source(const char *path) {
+    LoadedSource *source = calloc(1, sizeof(LoadedSource));
+    if (!read_source_file(path, &source->file)) {
+        free(source);
+        return NULL;
+    }
+    source->refs = 1;
+
+    const char *data = source->file.data;
+    gssize length = (gssize)source->file.length;
+    if (length > 0 && !g_utf8_validate(data, length, NULL)) {
+        gsize written = 0;
+        char *utf8 = g_locale_to_utf8(data, length, NULL, &written, NULL);
+        if (!utf8) {
+            utf8 = g_utf8_make_valid(data, length);
+            written = strlen(utf8);
+        }
+        char *copy = malloc(written + 1);
+        memcpy(copy, utf8, written + 1);
+        g_free(utf8);
+        source_take_buffer(&source->file, copy, written);
+    }
+    return source;
 }
 
 static void set_label_text_utf8(GtkLabel *label, const char *text) {
@@ -51,102 +143,192 @@ static void set_label_text_utf8(GtkLabel *label, const char *text) {
     g_free(safe);
 }
 
-static void replace_program_output(AppWidgets *widgets, char *owned_text) {
-    if (!widgets) {
-        if (owned_text) {
-            free(owned_text);
+static void stop_text_fill(TextFill *fill) {
+    if (fill->source_id) {
+        g_source_remove(fill->source_id);
+        fill->source_id = 0;
+    }
+    g_free(fill->text);
+    fill->text = NULL;
+    fill->length = 0;
+    fill->offset = 0;
+}
+
+static gboolean fill_text_step(gpointer data) {
+    TextFill *fill = (TextFill *)data;
+
+    size_t end = fill->offset + FILL_CHUNK_SIZE;
+    if (end >= fill->length) {
+        end = fill->length;
+    } else {
+        // never split a UTF-8 sequence between two inserts
+        while (end > fill->offset && ((unsigned char)fill->text[end] & 0xC0) == 0x80) {
+            end--;
         }
-        return;
     }
 
-    if (widgets->program_output) {
-        free(widgets->program_output);
+    GtkTextIter iter;
+    gtk_text_buffer_get_end_iter(fill->buffer, &iter);
+    gtk_text_buffer_insert(fill->buffer, &iter, fill->text + fill->offset, (gint)(end - fill->offset));
+    fill->offset = end;
+
+    if (fill->offset < fill->length) {
+        return G_SOURCE_CONTINUE;
     }
+    fill->source_id = 0;
+    stop_text_fill(fill);
+    return G_SOURCE_REMOVE;
+}
 
-    const char *src = owned_text ? owned_text : "";
-    widgets->program_output = g_utf8_make_valid(src, -1);
-    if (owned_text) {
-        free(owned_text);
+// Replace the buffer contents, inserting large texts chunk by chunk from idle
+// callbacks; a newer text cancels whatever is still being inserted
+static void fill_text_buffer(TextFill *fill, const char *text, size_t length) {
+    stop_text_fill(fill);
+    fill->text = g_utf8_make_valid(text ? text : "", text ? (gssize)length : 0);
+    fill->length = strlen(fill->text);
+
+    gtk_text_buffer_set_text(fill->buffer, "", 0);
+    if (fill_text_step(fill) == G_SOURCE_CONTINUE) {
+        fill->source_id = g_idle_add(fill_text_step, fill);
     }
 }
 
-// Update variables display
-void update_variables_display(AppWidgets *widgets) {
-    if (!widgets) {
+static void show_text(TextFill *fill, const char *text) {
+    fill_text_buffer(fill, text, text ? strlen(text) : 0);
+}
+
+static void show_report(TextFill *fill, const Analysis *analysis,
+                        void (*write_report)(const Analysis *, OutputBuffer *)) {
+    OutputBuffer report;
+    init_output_buffer(&report);
+    write_report(analysis, &report);
+    fill_text_buffer(fill, report.data, report.length);
+    free_output_buffer(&report);
+}
+
+// Refresh the Diagnostics table from the live document
+static void show_diagnostics(AppWidgets *widgets, gint64 elapsed_us) {
+    const Analysis *analysis = &widgets->document.analysis;
+    set_table_analysis(widgets->error_view, TABLE_ERRORS, analysis);
+
+    char status[128];
+    snprintf(status, sizeof(status), "%d diagnostic(s), %d line(s), updated in %.2f ms",
+             analysis->errorList.count, widgets->document.line_count, elapsed_us / 1000.0);
+    gtk_label_set_text(GTK_LABEL(widgets->diagnostics_label), status);
+}
+
+// The two handlers below run before GTK applies an edit and record which
+// lines it replaces; on_source_changed then hands just those lines over.
+static void begin_source_edit(AppWidgets *widgets, int first_line, int old_count) {
+    if (widgets->loading_source) {
         return;
     }
+    if (widgets->edit_pending) {
+        widgets->edit_overlapped = TRUE;
+    }
+    widgets->edit_first_line = first_line;
+    widgets->edit_old_count = old_count;
+    widgets->edit_pending = TRUE;
+}
 
-    GString *text = g_string_new(NULL);
-    const char *type_names[] = {"Integer", "Real", "String", "Unknown"};
+static void on_source_insert_text(GtkTextBuffer *buffer, GtkTextIter *location,
+                                  gchar *text, gint length, gpointer user_data) {
+    begin_source_edit((AppWidgets *)user_data, gtk_text_iter_get_line(location), 1);
+}
 
-    g_string_append(text, "========================================\n");
-    g_string_append(text, "        DECLARED VARIABLES\n");
-    g_string_append(text, "========================================\n\n");
+static void on_source_delete_range(GtkTextBuffer *buffer, GtkTextIter *start,
+                                   GtkTextIter *end, gpointer user_data) {
+    int first = gtk_text_iter_get_line(start);
+    begin_source_edit((AppWidgets *)user_data, first, gtk_text_iter_get_line(end) - first + 1);
+}
 
-    if (widgets->symbolTable.count == 0) {
-        g_string_append(text, "No variables declared yet.\n");
+static void on_source_changed(GtkTextBuffer *buffer, gpointer user_data) {
+    AppWidgets *widgets = (AppWidgets *)user_data;
+    if (widgets->loading_source || !widgets->edit_pending) {
+        return;
+    }
+    widgets->edit_pending = FALSE;
+    widgets->source_modified = TRUE;
+
+    gint64 start_time = g_get_monotonic_time();
+    GtkTextIter start;
+    GtkTextIter end;
+    if (widgets->edit_overlapped) {
+        widgets->edit_overlapped = FALSE;
+        gtk_text_buffer_get_bounds(buffer, &start, &end);
+        char *text = gtk_text_buffer_get_text(buffer, &start, &end, TRUE);
+        document_set_text(&widgets->document, text, strlen(text));
+        g_free(text);
     } else {
-        g_string_append(text, "Variable Name        Type            Value\n");
-        g_string_append(text, "-------------------  --------------  ----------------\n");
-
-        for (int i = 0; i < widgets->symbolTable.count; i++) {
-            Symbol *sym = &widgets->symbolTable.symbols[i];
-            g_string_append_printf(text, "%-20s %-15s %s\n",
-                                   sym->id,
-                                   type_names[sym->type],
-                                   sym->value ? sym->value : "uninitialized");
+        // lines below the edit are untouched, so whatever is left between
+        // them and the first edited line is the replacement
+        int first = widgets->edit_first_line;
+        int untouched = widgets->document.line_count - first - widgets->edit_old_count;
+        int line_count = gtk_text_buffer_get_line_count(buffer);
+        int new_count = line_count - untouched - first;
+        gtk_text_buffer_get_iter_at_line(buffer, &start, first);
+        if (first + new_count < line_count) {
+            gtk_text_buffer_get_iter_at_line(buffer, &end, first + new_count);
+        } else {
+            gtk_text_buffer_get_end_iter(buffer, &end);
         }
-
-        g_string_append_printf(text, "\nTotal Variables: %d\n", widgets->symbolTable.count);
+        char *text = gtk_text_buffer_get_text(buffer, &start, &end, TRUE);
+        document_replace_lines(&widgets->document, first, widgets->edit_old_count, new_count,
+                               text, strlen(text));
+        g_free(text);
     }
+    show_diagnostics(widgets, g_get_monotonic_time() - start_time);
+}
 
-    g_string_append(text, "\n========================================\n");
-    g_string_append(text, "          PROGRAM OUTPUT\n");
-    g_string_append(text, "========================================\n\n");
+// Load file content into source text view
+void load_file_content(AppWidgets *widgets, const char *filepath) {
+    loaded_source_unref(widgets->source);
+    widgets->source = load_source(filepath);
+    if (!widgets->source) {
+        widgets->source_modified = FALSE;
+        show_text(&widgets->result_fill, "Error: Cannot open file");
+        return;
+    }
 
-    const char *output_text = (widgets->program_output && widgets->program_output[0] != '\0')
-        ? widgets->program_output
-        : "No FRG_Print output generated.\n";
+    const SourceFile *file = &widgets->source->file;
+    widgets->loading_source = TRUE;
+    gtk_text_buffer_set_text(widgets->source_buffer, file->length > 0 ? file->data : "", (gint)file->length);
+    widgets->loading_source = FALSE;
+    widgets->source_modified = FALSE;
+    widgets->edit_pending = FALSE;
+    document_set_text(&widgets->document, file->data, file->length);
+    show_diagnostics(widgets, 0);
+}
 
-    g_string_append(text, output_text);
-    if(text->len == 0 || text->str[text->len - 1] != '\n') {
-        g_string_append_c(text, '\n');
+// Drop the running analysis; its job frees itself when it reaches the main loop
+static void cancel_pending_analysis(AppWidgets *widgets) {
+    if (widgets->pending_job) {
+        g_cancellable_cancel(widgets->pending_job->cancellable);
+        widgets->pending_job = NULL;
     }
-
-    gtk_text_buffer_set_text(widgets->variables_buffer, text->str, -1);
-    g_string_free(text, TRUE);
 }
 
-// Load file content into source text view
-void load_file_content(AppWidgets *widgets, const char *filepath) {
-    FILE *file = fopen(filepath, "rb");
-    if (!file) {
-        set_buffer_text_utf8(widgets->result_buffer, "Error: Cannot open file");
+// Point the tables at an analysis; NULL detaches them before it is freed
+static void show_tables(AppWidgets *widgets, const Analysis *analysis) {
+    if (widgets->table_analysis == analysis) {
         return;
     }
-    
-    // Read file content
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    char *content = malloc(size + 1);
-    fread(content, 1, size, file);
-    content[size] = '\0';
-    fclose(file);
-    
-    GError *err = NULL;
-    char *utf8 = g_locale_to_utf8(content, -1, NULL, NULL, &err);
-    if (!utf8) {
-        if (err) {
-            g_error_free(err);
-            err = NULL;
-        }
-        utf8 = g_utf8_make_valid(content, -1);
+    widgets->table_analysis = analysis;
+    set_table_analysis(widgets->token_view, TABLE_TOKENS, analysis);
+    set_table_analysis(widgets->symbol_view, TABLE_SYMBOLS, analysis);
+}
+
+// Detach the shown analysis and keep it for the next job to refill
+static void retire_analysis(AppWidgets *widgets) {
+    if (!widgets->analysis) {
+        return;
     }
-    set_buffer_text_utf8(widgets->source_buffer, utf8);
-    g_free(utf8);
-    free(content);
+    show_tables(widgets, NULL);
+    free_analysis(widgets->spare_analysis);
+    widgets->spare_analysis = widgets->analysis;
+    widgets->analysis = NULL;
+    free(widgets->analyzed_text);
+    widgets->analyzed_text = NULL;
 }
 
 // File chooser callback
@@ -165,265 +347,178 @@ void on_file_chosen(GtkFileChooserButton *button, gpointer user_data) {
             free(widgets->current_file_path);
         }
         widgets->current_file_path = strdup(filename);
+        cancel_pending_analysis(widgets);
+        retire_analysis(widgets);
         
         // Load file content
         load_file_content(widgets, filename);
         
         // Clear result and variables
-        set_buffer_text_utf8(widgets->result_buffer, "File loaded. Click analysis buttons to proceed.");
-        set_buffer_text_utf8(widgets->variables_buffer, "No analysis performed yet.");
-        replace_program_output(widgets, NULL);
+        show_text(&widgets->result_fill, "File loaded. Click analysis buttons to proceed.");
+        show_text(&widgets->variables_fill, "No analysis performed yet.");
         
         g_free(filename);
     }
 }
 
-// Lexical Analysis Button Callback
-void on_lexical_analysis(GtkWidget *button, gpointer user_data) {
-    AppWidgets *widgets = (AppWidgets *)user_data;
-
-    if (!widgets->current_file_path) {
-        set_buffer_text_utf8(widgets->result_buffer, "Please select a file first!");
-        return;
+static void show_results(AppWidgets *widgets, AnalysisView view, const Analysis *analysis) {
+    show_tables(widgets, analysis);
+    switch (view) {
+        case VIEW_LEXICAL:
+            show_report(&widgets->result_fill, analysis, write_lexical_report);
+            return;
+        case VIEW_SYNTAX:
+            show_report(&widgets->result_fill, analysis, write_syntax_report);
+            break;
+        case VIEW_SEMANTIC:
+            show_report(&widgets->result_fill, analysis, write_semantic_report);
+            break;
     }
+    show_report(&widgets->variables_fill, analysis, write_variables_report);
+}
 
-    // Reset data structures
-    widgets->tokenList = (TokenList){NULL, 0, 0};
-    widgets->errorList = (ErrorList){NULL, 0, 0};
-
-    // Run lexical analysis
-    lexer(widgets->current_file_path, &widgets->tokenList, &widgets->errorList);
-
-    // Build result string
-    char result[8192] = {0};
-    strcat(result, "========================================\n");
-    strcat(result, "      LEXICAL ANALYSIS RESULTS\n");
-    strcat(result, "========================================\n\n");
-
-    // Token names
-    const char *token_names[] = {
-        "NONE",
-        "KEYWORD_BEGIN",
-        "KEYWORD_END",
-        "KEYWORD_INT",
-        "KEYWORD_REAL",
-        "KEYWORD_STRING",
-        "KEYWORD_PRINT",
-        "KEYWORD_IF",
-        "KEYWORD_ELSE",
-        "KEYWORD_REPEAT",
-        "KEYWORD_UNTIL",
-        "BLOCK_BEGIN",
-        "BLOCK_END",
-        "IDENTIFIER",
-        "INTEGER_LITERAL",
-        "FLOAT_LITERAL",
-        "STRING_LITERAL",
-        "ASSIGN_OP",
-        "END_INSTRUCTION",
-        "COMMENT",
-        "COMMA",
-        "OPEN_BRACKET",
-        "CLOSE_BRACKET",
-        "OPEN_PAREN",
-        "CLOSE_PAREN",
-        "OPERATOR_PLUS",
-        "OPERATOR_MINUS",
-        "OPERATOR_MULTIPLY",
-        "OPERATOR_DIVIDE",
-        "RELATIONAL_OP"
-    };
-
-    // Add tokens
-    char temp[256];
-    sprintf(temp, "Total Tokens: %d\n\n", widgets->tokenList.count);
-    strcat(result, temp);
-
-    strcat(result, "Line  Type                 Value\n");
-    strcat(result, "----  -------------------  --------------------\n");
-
-    for (int i = 0; i < widgets->tokenList.count && i < 100; i++) {
-        sprintf(temp, "%-4d  %-20s '%s'\n",
-                widgets->tokenList.tokens[i].line,
-                token_names[widgets->tokenList.tokens[i].type],
-                widgets->tokenList.tokens[i].value);
-        strcat(result, temp);
-    }
+static void free_analysis_job(AnalysisJob *job) {
+    free_analysis(job->analysis);
+    g_object_unref(job->cancellable);
+    loaded_source_unref(job->source);
+    free(job->text);
+    free(job);
+}
+
+static int job_cancelled(void *cancellable) {
+    return g_cancellable_is_cancelled((GCancellable *)cancellable);
+}
 
-    // Add errors
-    strcat(result, "\n========================================\n");
-    strcat(result, "           LEXICAL ERRORS\n");
-    strcat(result, "========================================\n");
-
-    int error_count = 0;
-    for (int i = 0; i < widgets->errorList.count; i++) {
-        if (widgets->errorList.errors[i].type == LEXICAL_ERR) {
-            sprintf(temp, "Line %d: %s\n",
-                    widgets->errorList.errors[i].line,
-                    widgets->errorList.errors[i].err_message);
-            strcat(result, temp);
-            error_count++;
+// Runs on the main loop once the worker thread has finished
+static gboolean deliver_analysis(gpointer data) {
+    AnalysisJob *job = (AnalysisJob *)data;
+    AppWidgets *widgets = job->widgets;
+
+    // a newer file was chosen in the meantime; nobody is waiting for this,
+    // but its memory can still serve the next job
+    if (g_cancellable_is_cancelled(job->cancellable)) {
+        if (!widgets->spare_analysis) {
+            widgets->spare_analysis = job->analysis;
+            job->analysis = NULL;
         }
+        free_analysis_job(job);
+        return G_SOURCE_REMOVE;
     }
+    widgets->pending_job = NULL;
+
+    retire_analysis(widgets);
+    widgets->analysis = job->analysis;
+    job->analysis = NULL;
+    widgets->analyzed_text = job->text;
+    widgets->analyzed_length = job->text_length;
+    job->text = NULL;
+    show_results(widgets, job->view, widgets->analysis);
+    free_analysis_job(job);
+    return G_SOURCE_REMOVE;
+}
 
-    if (error_count == 0) {
-        strcat(result, "No lexical errors found! ✓\n");
+static gpointer analysis_worker(gpointer data) {
+    AnalysisJob *job = (AnalysisJob *)data;
+    if (!job->analysis) {
+        job->analysis = new_analysis();
     }
+    if (job->text) {
+        run_analysis(job->analysis, job->text, job->text_length, job_cancelled, job->cancellable);
+    } else {
+        const SourceFile *file = &job->source->file;
+        run_analysis(job->analysis, file->data, file->length, job_cancelled, job->cancellable);
+    }
+    g_idle_add(deliver_analysis, job);
+    return NULL;
+}
 
-    sprintf(temp, "\nTotal Lexical Errors: %d\n", error_count);
-    strcat(result, temp);
-
-    // Display result
-    set_buffer_text_utf8(widgets->result_buffer, result);
-    replace_program_output(widgets, NULL);
+// Whether a job analyzes exactly the text the buffer holds now
+static gboolean job_matches_document(const AnalysisJob *job, const Document *document) {
+    const char *text = job->text ? job->text : job->source->file.data;
+    size_t length = job->text ? job->text_length : job->source->file.length;
+    return length == document->length && (length == 0 || memcmp(text, document->text, length) == 0);
 }
 
-// Syntax Analysis Button Callback
-void on_syntax_analysis(GtkWidget *button, gpointer user_data) {
-    AppWidgets *widgets = (AppWidgets *)user_data;
+// Whether the last analysis was made from exactly the text the buffer holds now
+static gboolean analysis_matches_document(const AppWidgets *widgets, const Document *document) {
+    const char *text = widgets->analyzed_text;
+    size_t length = widgets->analyzed_length;
+    if (!text) {
+        if (!widgets->source) {
+            return FALSE;
+        }
+        text = widgets->source->file.data;
+        length = widgets->source->file.length;
+    }
+    return length == document->length && (length == 0 || memcmp(text, document->text, length) == 0);
+}
 
+// Show a view from the last analysis, or analyze the source in the background
+// when it is new or has been edited since the last click
+static void request_analysis(AppWidgets *widgets, AnalysisView view) {
     if (!widgets->current_file_path) {
-        set_buffer_text_utf8(widgets->result_buffer, "Please select a file first!");
+        show_text(&widgets->result_fill, "Please select a file first!");
+        return;
+    }
+    if (!widgets->source && !widgets->source_modified) {
+        show_text(&widgets->result_fill, "Error: Cannot open file");
+        return;
+    }
+
+    // once edited, the buffer rather than the file is what gets analyzed; an
+    // analysis of the unedited file stays valid until another file is chosen
+    const Document *document = &widgets->document;
+    Analysis *analysis = widgets->analysis;
+    if (analysis && widgets->source_modified && !analysis_matches_document(widgets, document)) {
+        analysis = NULL;
+    }
+    if (analysis) {
+        show_results(widgets, view, analysis);
         return;
     }
 
-    // Reset and run lexical first
-    widgets->tokenList = (TokenList){NULL, 0, 0};
-    widgets->errorList = (ErrorList){NULL, 0, 0};
-    widgets->symbolTable = (SymbolTable){NULL, 0, 0};
-
-    lexer(widgets->current_file_path, &widgets->tokenList, &widgets->errorList);
-
-    // Run parser (syntax analysis)
-    OutputBuffer exec_output;
-    init_output_buffer(&exec_output);
-
-    Parser parser;
-    init_parser(&parser, &widgets->tokenList, &widgets->symbolTable, &widgets->errorList, &exec_output);
-    parse(&parser);
-
-    char *program_output = detach_output_buffer(&exec_output);
-    replace_program_output(widgets, program_output);
-
-    // Build result string
-    char result[8192] = {0};
-    strcat(result, "========================================\n");
-    strcat(result, "       SYNTAX ANALYSIS RESULTS\n");
-    strcat(result, "========================================\n\n");
-
-    // Add syntax errors
-    char temp[256];
-    int error_count = 0;
-
-    for (int i = 0; i < widgets->errorList.count; i++) {
-        if (widgets->errorList.errors[i].type == SYNTAX_ERR) {
-            sprintf(temp, "Line %d: %s\n",
-                    widgets->errorList.errors[i].line,
-                    widgets->errorList.errors[i].err_message);
-            strcat(result, temp);
-            error_count++;
+    // already analyzing this text; show the most recently requested view.
+    // A job started before the latest edits is restarted on the new text.
+    if (widgets->pending_job) {
+        if (!widgets->source_modified || job_matches_document(widgets->pending_job, document)) {
+            widgets->pending_job->view = view;
+            return;
         }
+        cancel_pending_analysis(widgets);
     }
 
-    if (error_count == 0) {
-        strcat(result, "No syntax errors found! ✓\n\n");
-        strcat(result, "Program structure is correct:\n");
-        strcat(result, "- Starts with FRG_Begin\n");
-        strcat(result, "- Ends with FRG_End\n");
-        strcat(result, "- All instructions properly terminated with #\n");
+    AnalysisJob *job = calloc(1, sizeof(AnalysisJob));
+    job->widgets = widgets;
+    job->view = view;
+    job->cancellable = g_cancellable_new();
+    if (widgets->source_modified) {
+        job->text = malloc(document->length + 1);
+        memcpy(job->text, document->text, document->length + 1);
+        job->text_length = document->length;
     } else {
-        sprintf(temp, "\nTotal Syntax Errors: %d\n", error_count);
-        strcat(result, temp);
+        job->source = loaded_source_ref(widgets->source);
     }
+    job->analysis = widgets->spare_analysis;
+    widgets->spare_analysis = NULL;
 
-    // Display result
-    set_buffer_text_utf8(widgets->result_buffer, result);
+    widgets->pending_job = job;
+    show_text(&widgets->result_fill, "Analyzing file...");
+    g_thread_unref(g_thread_new("frog-analysis", analysis_worker, job));
+}
 
-    // Update variables display
-    update_variables_display(widgets);
+// Lexical Analysis Button Callback
+void on_lexical_analysis(GtkWidget *button, gpointer user_data) {
+    request_analysis((AppWidgets *)user_data, VIEW_LEXICAL);
+}
+
+// Syntax Analysis Button Callback
+void on_syntax_analysis(GtkWidget *button, gpointer user_data) {
+    request_analysis((AppWidgets *)user_data, VIEW_SYNTAX);
 }
 
 // Semantic Analysis Button Callback
 void on_semantic_analysis(GtkWidget *button, gpointer user_data) {
-    AppWidgets *widgets = (AppWidgets *)user_data;
-    
-    if (!widgets->current_file_path) {
-        set_buffer_text_utf8(widgets->result_buffer, "Please select a file first!");
-        return;
-    }
-    
-    // Reset and run full analysis
-    widgets->tokenList = (TokenList){NULL, 0, 0};
-    widgets->errorList = (ErrorList){NULL, 0, 0};
-    widgets->symbolTable = (SymbolTable){NULL, 0, 0};
-    
-    lexer(widgets->current_file_path, &widgets->tokenList, &widgets->errorList);
-    
-    OutputBuffer exec_output;
-    init_output_buffer(&exec_output);
-
-    Parser parser;
-    init_parser(&parser, &widgets->tokenList, &widgets->symbolTable, &widgets->errorList, &exec_output);
-    parse(&parser);
-
-    char *program_output = detach_output_buffer(&exec_output);
-    replace_program_output(widgets, program_output);
-    
-    // Build result string
-    char result[8192] = {0};
-    strcat(result, "========================================\n");
-    strcat(result, "      SEMANTIC ANALYSIS RESULTS\n");
-    strcat(result, "========================================\n\n");
-    
-    // Add semantic errors
-    char temp[256];
-    int error_count = 0;
-    
-    for (int i = 0; i < widgets->errorList.count; i++) {
-        if (widgets->errorList.errors[i].type == SEMANTIC_ERR) {
-            sprintf(temp, "Line %d: %s\n",
-                    widgets->errorList.errors[i].line,
-                    widgets->errorList.errors[i].err_message);
-            strcat(result, temp);
-            error_count++;
-        }
-    }
-    
-    if (error_count == 0) {
-        strcat(result, "No semantic errors found! ✓\n\n");
-    } else {
-        sprintf(temp, "\nTotal Semantic Errors: %d\n\n", error_count);
-        strcat(result, temp);
-    }
-    
-    // Add symbol table
-    strcat(result, "========================================\n");
-    strcat(result, "          SYMBOL TABLE\n");
-    strcat(result, "========================================\n\n");
-    
-    const char *type_names[] = {"Integer", "Real", "String", "Unknown"};
-    
-    strcat(result, "Name                Type            Value\n");
-    strcat(result, "-------------------  --------------  --------------\n");
-    
-    for (int i = 0; i < widgets->symbolTable.count; i++) {
-        Symbol *sym = &widgets->symbolTable.symbols[i];
-        sprintf(temp, "%-20s %-15s %s\n",
-                sym->id,
-                type_names[sym->type],
-                sym->value ? sym->value : "uninitialized");
-        strcat(result, temp);
-    }
-    
-    if (widgets->symbolTable.count == 0) {
-        strcat(result, "(No variables declared)\n");
-    }
-    
-    // Display result
-    set_buffer_text_utf8(widgets->result_buffer, result);
-    
-    // Update variables display
-    update_variables_display(widgets);
+    request_analysis((AppWidgets *)user_data, VIEW_SEMANTIC);
 }
 
 // Create GUI
@@ -463,6 +558,10 @@ void create_gui(AppWidgets *widgets) {
     widgets->file_path_label = gtk_label_new("No file selected");
     gtk_label_set_xalign(GTK_LABEL(widgets->file_path_label), 0);
     gtk_box_pack_start(GTK_BOX(main_vbox), widgets->file_path_label, FALSE, FALSE, 0);
+
+    widgets->diagnostics_label = gtk_label_new("");
+    gtk_label_set_xalign(GTK_LABEL(widgets->diagnostics_label), 0);
+    gtk_box_pack_start(GTK_BOX(main_vbox), widgets->diagnostics_label, FALSE, FALSE, 0);
     
     // Analysis buttons
     GtkWidget *button_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
@@ -497,25 +596,48 @@ void create_gui(AppWidgets *widgets) {
     gtk_container_add(GTK_CONTAINER(source_frame), source_scroll);
     
     widgets->source_text_view = gtk_text_view_new();
-    gtk_text_view_set_editable(GTK_TEXT_VIEW(widgets->source_text_view), FALSE);
     gtk_text_view_set_monospace(GTK_TEXT_VIEW(widgets->source_text_view), TRUE);
     widgets->source_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(widgets->source_text_view));
+    g_signal_connect(widgets->source_buffer, "insert-text",
+                     G_CALLBACK(on_source_insert_text), widgets);
+    g_signal_connect(widgets->source_buffer, "delete-range",
+                     G_CALLBACK(on_source_delete_range), widgets);
+    g_signal_connect(widgets->source_buffer, "changed",
+                     G_CALLBACK(on_source_changed), widgets);
     gtk_container_add(GTK_CONTAINER(source_scroll), widgets->source_text_view);
     
     // Result frame
     GtkWidget *result_frame = gtk_frame_new("Analysis Results");
     gtk_box_pack_start(GTK_BOX(text_hbox), result_frame, TRUE, TRUE, 0);
     
+    GtkWidget *result_notebook = gtk_notebook_new();
+    gtk_container_add(GTK_CONTAINER(result_frame), result_notebook);
+
     GtkWidget *result_scroll = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(result_scroll),
                                    GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
-    gtk_container_add(GTK_CONTAINER(result_frame), result_scroll);
+    gtk_notebook_append_page(GTK_NOTEBOOK(result_notebook), result_scroll, gtk_label_new("Report"));
     
     widgets->result_text_view = gtk_text_view_new();
     gtk_text_view_set_editable(GTK_TEXT_VIEW(widgets->result_text_view), FALSE);
     gtk_text_view_set_monospace(GTK_TEXT_VIEW(widgets->result_text_view), TRUE);
     widgets->result_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(widgets->result_text_view));
+    widgets->result_fill.buffer = widgets->result_buffer;
     gtk_container_add(GTK_CONTAINER(result_scroll), widgets->result_text_view);
+
+    // Tokens, symbols and diagnostics as virtualized tables
+    widgets->token_view = create_table_view(TABLE_TOKENS);
+    widgets->symbol_view = create_table_view(TABLE_SYMBOLS);
+    widgets->error_view = create_table_view(TABLE_ERRORS);
+    GtkWidget *table_views[] = {widgets->token_view, widgets->symbol_view, widgets->error_view};
+    const char *table_titles[] = {"Tokens", "Symbols", "Diagnostics"};
+    for (int i = 0; i < 3; i++) {
+        GtkWidget *table_scroll = gtk_scrolled_window_new(NULL, NULL);
+        gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(table_scroll),
+                                       GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+        gtk_container_add(GTK_CONTAINER(table_scroll), table_views[i]);
+        gtk_notebook_append_page(GTK_NOTEBOOK(result_notebook), table_scroll, gtk_label_new(table_titles[i]));
+    }
     
     // NEW: Variables display section at bottom (50% width)
     GtkWidget *bottom_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
@@ -535,14 +657,16 @@ void create_gui(AppWidgets *widgets) {
     gtk_text_view_set_editable(GTK_TEXT_VIEW(widgets->variables_text_view), FALSE);
     gtk_text_view_set_monospace(GTK_TEXT_VIEW(widgets->variables_text_view), TRUE);
     widgets->variables_buffer = gtk_text_view_get_buffer(GTK_TEXT_VIEW(widgets->variables_text_view));
+    widgets->variables_fill.buffer = widgets->variables_buffer;
     gtk_container_add(GTK_CONTAINER(variables_scroll), widgets->variables_text_view);
     
     // Initial message
-    set_buffer_text_utf8(widgets->result_buffer,
+    show_text(&widgets->result_fill,
         "Welcome to FROG Compiler!\n\nPlease select a .frg file to begin analysis.");
 
-    set_buffer_text_utf8(widgets->variables_buffer,
+    show_text(&widgets->variables_fill,
         "No analysis performed yet.");
+    show_diagnostics(widgets, 0);
 }
 
 int main(int argc, char *argv[]) {
@@ -550,7 +674,7 @@ int main(int argc, char *argv[]) {
     
     AppWidgets widgets = {0};
     widgets.current_file_path = NULL;
-    widgets.program_output = NULL;
+    init_document(&widgets.document);
     
     create_gui(&widgets);
     gtk_widget_show_all(widgets.window);
@@ -559,9 +683,14 @@ int main(int argc, char *argv[]) {
     if (widgets.current_file_path) {
         free(widgets.current_file_path);
     }
-    if (widgets.program_output) {
-        free(widgets.program_output);
-    }
+    cancel_pending_analysis(&widgets);
+    free_analysis(widgets.analysis);
+    free(widgets.analyzed_text);
+    free_analysis(widgets.spare_analysis);
+    loaded_source_unref(widgets.source);
+    stop_text_fill(&widgets.result_fill);
+    stop_text_fill(&widgets.variables_fill);
+    free_document(&widgets.document);
     
     return 0;
 
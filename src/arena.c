@@ -0,0 +1,139 @@
+#include "../include/arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_FIRST_BLOCK 4096
+#define ARENA_MAX_BLOCK 65536
+#define ARENA_ALIGN sizeof(void *)
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+//makes a block with at least `need` free bytes the newest one; blocks start
+//small, so a file with a handful of diagnostics stays cheap
+static void new_block(Arena *arena, size_t need){
+    ArenaBlock *block = arena->spare;
+    if(block != NULL && block->size >= need){
+        arena->spare = block->next;
+    } else {
+        size_t size = arena->blocks != NULL ? arena->blocks->size * 2 : ARENA_FIRST_BLOCK;
+        if(size > ARENA_MAX_BLOCK){
+            size = ARENA_MAX_BLOCK;
+        }
+        if(size < need){
+            size = need;
+        }
+        block = malloc(sizeof(ArenaBlock) + size);
+        block->size = size;
+    }
+    block->used = 0;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    if(arena->oldest == NULL){
+        arena->oldest = block;
+    }
+}
+
+static void *take(Arena *arena, size_t size, size_t align){
+    ArenaBlock *block = arena->blocks;
+    size_t start = block != NULL ? (block->used + align - 1) & ~(align - 1) : 0;
+    if(block == NULL || start + size > block->size){
+        new_block(arena, size);
+        block = arena->blocks;
+        start = 0;
+    }
+    block->used = start + size;
+    return block->data + start;
+}
+
+void *arena_alloc(Arena *arena, size_t size){
+    return take(arena, size, ARENA_ALIGN);
+}
+
+//strings are packed without alignment
+char *arena_strndup(Arena *arena, const char *text, size_t length){
+    char *copy = take(arena, length + 1, 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+char *arena_strdup(Arena *arena, const char *text){
+    return arena_strndup(arena, text, strlen(text));
+}
+
+//position must come from this arena; everything allocated after it (and it
+//too) is dropped. Only valid while the arena has not been merged into.
+void arena_rewind(Arena *arena, const void *position){
+    const char *at = position;
+    while(arena->blocks != NULL){
+        ArenaBlock *block = arena->blocks;
+        if(at >= block->data && at <= block->data + block->used){
+            block->used = (size_t)(at - block->data);
+            return;
+        }
+        arena->blocks = block->next;
+        block->next = arena->spare;
+        arena->spare = block;
+    }
+    arena->oldest = NULL;
+}
+
+void arena_reset(Arena *arena){
+    if(arena->blocks == NULL){
+        return;
+    }
+    arena->oldest->next = arena->spare;
+    arena->spare = arena->blocks;
+    arena->blocks = NULL;
+    arena->oldest = NULL;
+}
+
+//hands every allocation of `from` over to `into` without copying; `from`
+//is left empty
+void arena_merge(Arena *into, Arena *from){
+    if(from->blocks != NULL){
+        if(into->blocks == NULL){
+            into->blocks = from->blocks;
+            into->oldest = from->oldest;
+        } else {
+            //behind into's newest block, which keeps filling up
+            from->oldest->next = into->blocks->next;
+            into->blocks->next = from->blocks;
+            if(into->oldest == into->blocks){
+                into->oldest = from->oldest;
+            }
+        }
+        from->blocks = NULL;
+        from->oldest = NULL;
+    }
+    arena_free(from);
+}
+
+//bytes handed out, counting alignment padding
+size_t arena_bytes(const Arena *arena){
+    size_t total = 0;
+    for(const ArenaBlock *block = arena->blocks; block != NULL; block = block->next){
+        total += block->used;
+    }
+    return total;
+}
+
+void arena_free(Arena *arena){
+    ArenaBlock *lists[] = {arena->blocks, arena->spare};
+    for(int i = 0; i < 2; i++){
+        ArenaBlock *block = lists[i];
+        while(block != NULL){
+            ArenaBlock *next = block->next;
+            free(block);
+            block = next;
+        }
+    }
+    arena->blocks = NULL;
+    arena->oldest = NULL;
+    arena->spare = NULL;
+}
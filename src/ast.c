@@ -0,0 +1,80 @@
+#include "../include/ast.h"
+#include <string.h>
+#include <stdlib.h>
+
+void init_ast(Ast *ast){
+    memset(ast, 0, sizeof(*ast));
+    ast->root = -1;
+}
+
+//returns the index of the new node, pointers into nodes are invalidated
+int ast_add_node(Ast *ast, AstKind kind, int line){
+    if(ast->count >= ast->capacity){
+        ast->capacity = ast->capacity == 0 ? 64 : ast->capacity * 2;
+        ast->nodes = realloc(ast->nodes, sizeof(AstNode) * ast->capacity);
+    }
+
+    AstNode *node = &ast->nodes[ast->count];
+    memset(node, 0, sizeof(*node));
+    node->kind = kind;
+    node->line = line;
+    node->type = KEY_UNKNOWN;
+    node->symbol = -1;
+    node->left = -1;
+    node->right = -1;
+    node->extra = -1;
+    return ast->count++;
+}
+
+//lists are collected on a scratch stack while nested lists are parsed,
+//then copied contiguously into children once complete
+int ast_list_mark(Ast *ast){
+    return ast->scratch_count;
+}
+
+void ast_list_push(Ast *ast, int node){
+    if(node < 0){
+        return;
+    }
+    if(ast->scratch_count >= ast->scratch_capacity){
+        ast->scratch_capacity = ast->scratch_capacity == 0 ? 32 : ast->scratch_capacity * 2;
+        ast->scratch = realloc(ast->scratch, sizeof(int) * ast->scratch_capacity);
+    }
+    ast->scratch[ast->scratch_count++] = node;
+}
+
+void ast_list_finish(Ast *ast, int parent, int mark){
+    int length = ast->scratch_count - mark;
+    if(ast->child_count + length > ast->child_capacity){
+        while(ast->child_count + length > ast->child_capacity){
+            ast->child_capacity = ast->child_capacity == 0 ? 64 : ast->child_capacity * 2;
+        }
+        ast->children = realloc(ast->children, sizeof(int) * ast->child_capacity);
+    }
+
+    if(length > 0){
+        memcpy(ast->children + ast->child_count, ast->scratch + mark, sizeof(int) * length);
+    }
+    ast->nodes[parent].first_child = ast->child_count;
+    ast->nodes[parent].child_count = length;
+    ast->child_count += length;
+    ast->scratch_count = mark;
+}
+
+//empties the tree but keeps its arrays
+void clear_ast(Ast *ast){
+    ast->count = 0;
+    ast->child_count = 0;
+    ast->scratch_count = 0;
+    ast->root = -1;
+}
+
+void free_ast(Ast *ast){
+    if(ast == NULL){
+        return;
+    }
+    free(ast->nodes);
+    free(ast->children);
+    free(ast->scratch);
+    init_ast(ast);
+}
@@ -3,12 +3,12 @@
 #include <string.h>
 #include <stdlib.h>
 
-Error create_error(ErrorType type, const char *message, int line){
+Error create_error(ErrorType type, const char *message, unsigned int offset){
     Error error;
     error.type = type;
-    error.err_message = malloc(strlen(message)+1);
-    strcpy(error.err_message, message);
-    error.line = line;
+    error.err_message = message; //copied into the list by add_error
+    error.offset = offset;
+    error.at_line_start = 0;
     return error;
 };
 
@@ -23,17 +23,42 @@ void add_error(ErrorList *list, Error error){
         list -> capacity *= 2;
         list->errors = realloc(list->errors, sizeof(Error) * list->capacity);
     }
+    error.err_message = arena_strdup(&list->messages, error.err_message);
     list->errors[list->count++] = error;
 };
-void free_error_list(ErrorList *list){
-    if(list == NULL || list->errors == NULL){
+void truncate_error_list(ErrorList *list, int count){
+    if(list == NULL || count >= list->count){
         return;
     }
+    //messages are allocated in list order, so the dropped ones are the
+    //newest in the arena
+    arena_rewind(&list->messages, list->errors[count].err_message);
+    list->count = count;
+};
+
+//copies the live messages into a fresh arena, for lists whose messages
+//were not dropped from the end and so could not be rewound
+void compact_error_list(ErrorList *list){
+    Arena messages = {0};
+    for(int i = 0; i < list->count; i++){
+        list->errors[i].err_message = arena_strdup(&messages, list->errors[i].err_message);
+    }
+    arena_free(&list->messages);
+    list->messages = messages;
+};
 
-    for(int i=0 ; i < list->count ; i++){
-        free(list->errors[i].err_message);
+//empties the list but keeps the array and the messages' memory
+void clear_error_list(ErrorList *list){
+    arena_reset(&list->messages);
+    list->count = 0;
+};
+
+void free_error_list(ErrorList *list){
+    if(list == NULL || list->errors == NULL){
+        return;
     }
 
+    arena_free(&list->messages);
     free(list->errors);
     list->errors = NULL;
     list->count = 0;
@@ -41,7 +66,7 @@ void free_error_list(ErrorList *list){
 };
 
 
-void print_errors(ErrorList *list, ErrorType type){
+void print_errors(ErrorList *list, const LineMap *lines, ErrorType type){
     for(int i = 0; i < list->count; i++){
         if(list->errors[i].type == type){
             const char *type_str = "";
@@ -50,7 +75,9 @@ void print_errors(ErrorList *list, ErrorType type){
                 case LEXICAL_ERR: type_str = "Lexical"; break;
                 case SEMANTIC_ERR: type_str = "Semantic"; break;
             }
-            printf("Error (%s) [Line %d]: %s\n", type_str, list->errors[i].line, list->errors[i].err_message);
+            int line = source_line(lines, list->errors[i].offset, NULL);
+            printf("Error (%s) [Line %d, Column %d]: %s\n", type_str, line,
+                   source_column(lines, list->errors[i].offset, line), list->errors[i].err_message);
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "../include/scan.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCAN_AVX2 1
+#endif
+
+// Vector paths test a whole block against the class and stop at the first
+// byte outside it; shorter leftovers go through the table one byte at a time.
+
+const unsigned char scan_classes[256] = {
+    ['a' ... 'z'] = SCAN_ALPHA,
+    ['A' ... 'Z'] = SCAN_ALPHA,
+    ['_'] = SCAN_ALPHA,
+    ['0' ... '9'] = SCAN_DIGIT,
+    [' '] = SCAN_BLANK,
+    ['\t'] = SCAN_BLANK
+};
+
+static size_t scalar_run(const char *text, size_t i, size_t length, int classes){
+    while(i < length && scan_is(text[i], classes)){
+        i++;
+    }
+    return i;
+}
+
+#ifdef SCAN_SSE2
+//bytes >= 0x80 are negative as signed chars, so they fall outside every range
+static inline __m128i in_range16(__m128i x, char low, char high){
+    return _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8((char)(low - 1))),
+                         _mm_cmplt_epi8(x, _mm_set1_epi8((char)(high + 1))));
+}
+
+static inline __m128i class_mask16(__m128i x, int classes){
+    __m128i mask = _mm_setzero_si128();
+    if(classes & SCAN_ALPHA){
+        //setting bit 5 folds upper case onto lower case
+        __m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+        mask = _mm_or_si128(mask, in_range16(lower, 'a', 'z'));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(x, _mm_set1_epi8('_')));
+    }
+    if(classes & SCAN_DIGIT){
+        mask = _mm_or_si128(mask, in_range16(x, '0', '9'));
+    }
+    if(classes & SCAN_BLANK){
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+    }
+    return mask;
+}
+#endif
+
+#ifdef SCAN_AVX2
+__attribute__((target("avx2")))
+static inline __m256i in_range32(__m256i x, char low, char high){
+    return _mm256_and_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8((char)(low - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(high + 1)), x));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i class_mask32(__m256i x, int classes){
+    __m256i mask = _mm256_setzero_si256();
+    if(classes & SCAN_ALPHA){
+        __m256i lower = _mm256_or_si256(x, _mm256_set1_epi8(0x20));
+        mask = _mm256_or_si256(mask, in_range32(lower, 'a', 'z'));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_')));
+    }
+    if(classes & SCAN_DIGIT){
+        mask = _mm256_or_si256(mask, in_range32(x, '0', '9'));
+    }
+    if(classes & SCAN_BLANK){
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static size_t run_avx2(const char *text, size_t length, int classes){
+    size_t i = 0;
+    while(i + 32 <= length){
+        __m256i block = _mm256_loadu_si256((const __m256i *)(text + i));
+        unsigned int outside = ~(unsigned int)_mm256_movemask_epi8(class_mask32(block, classes));
+        if(outside != 0){
+            return i + (size_t)__builtin_ctz(outside);
+        }
+        i += 32;
+    }
+    return scalar_run(text, i, length, classes);
+}
+
+__attribute__((target("avx2")))
+static const char *find_avx2(const char *text, size_t length, char c){
+    __m256i needle = _mm256_set1_epi8(c);
+    size_t i = 0;
+    while(i + 32 <= length){
+        __m256i block = _mm256_loadu_si256((const __m256i *)(text + i));
+        unsigned int hits = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if(hits != 0){
+            return text + i + __builtin_ctz(hits);
+        }
+        i += 32;
+    }
+    return memchr(text + i, c, length - i);
+}
+
+static int have_avx2(void){
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+size_t scan_run(const char *text, size_t length, int classes){
+#ifdef SCAN_AVX2
+    //only worth the feature check for long runs
+    if(length >= 64 && have_avx2()){
+        return run_avx2(text, length, classes);
+    }
+#endif
+    size_t i = 0;
+#ifdef SCAN_SSE2
+    while(i + 16 <= length){
+        __m128i block = _mm_loadu_si128((const __m128i *)(text + i));
+        unsigned int outside = ~(unsigned int)_mm_movemask_epi8(class_mask16(block, classes)) & 0xFFFFu;
+        if(outside != 0){
+            return i + (size_t)__builtin_ctz(outside);
+        }
+        i += 16;
+    }
+#endif
+    return scalar_run(text, i, length, classes);
+}
+
+const char *scan_find(const char *text, size_t length, char c){
+#ifdef SCAN_AVX2
+    if(length >= 64 && have_avx2()){
+        return find_avx2(text, length, c);
+    }
+#endif
+    size_t i = 0;
+#ifdef SCAN_SSE2
+    __m128i needle = _mm_set1_epi8(c);
+    while(i + 16 <= length){
+        __m128i block = _mm_loadu_si128((const __m128i *)(text + i));
+        unsigned int hits = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if(hits != 0){
+            return text + i + __builtin_ctz(hits);
+        }
+        i += 16;
+    }
+#endif
+    return memchr(text + i, c, length - i);
+}
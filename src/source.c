@@ -0,0 +1,170 @@
+#include "../include/source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// single fread of the whole file, also the fallback when mapping is unavailable
+int read_source_file(const char *path, SourceFile *source){
+    FILE *f = fopen(path, "rb");
+    if(f == NULL){
+        return 0;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if(size < 0){
+        fclose(f);
+        return 0;
+    }
+
+    char *data = malloc((size_t)size + 1);
+    size_t read = fread(data, 1, (size_t)size, f);
+    fclose(f);
+    data[read] = '\0';
+
+    source->data = data;
+    source->length = read;
+    source->mapped = 0;
+    return 1;
+}
+
+int load_source_file(const char *path, SourceFile *source){
+    source->data = NULL;
+    source->length = 0;
+    source->mapped = 0;
+
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        return 0;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        close(fd);
+        return 0;
+    }
+
+    if(st.st_size == 0){
+        close(fd);
+        return 1;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map != MAP_FAILED){
+        madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        source->data = map;
+        source->length = (size_t)st.st_size;
+        source->mapped = 1;
+        return 1;
+    }
+#endif
+
+    return read_source_file(path, source);
+}
+
+void source_take_buffer(SourceFile *source, char *data, size_t length){
+    free_source_file(source);
+    source->data = data;
+    source->length = length;
+    source->mapped = 0;
+}
+
+void free_source_file(SourceFile *source){
+    if(source == NULL || source->data == NULL){
+        return;
+    }
+
+#ifndef _WIN32
+    if(source->mapped){
+        munmap((void *)source->data, source->length);
+    } else {
+        free((void *)source->data);
+    }
+#else
+    free((void *)source->data);
+#endif
+
+    source->data = NULL;
+    source->length = 0;
+    source->mapped = 0;
+}
+
+void add_line_start(LineMap *map, unsigned int offset){
+    if(map->count >= map->capacity){
+        map->capacity = map->capacity == 0 ? 64 : map->capacity * 2;
+        map->starts = realloc(map->starts, sizeof(unsigned int) * (size_t)map->capacity);
+    }
+    map->starts[map->count++] = offset;
+}
+
+//source_line when the hint misses: the last line starting at or before
+//offset. Lines just after the hinted one are tried before searching.
+int line_map_search(const LineMap *map, unsigned int offset, int *line_hint){
+    const unsigned int *starts = map->starts;
+    int count = map->count;
+    if(count == 0 || offset == NO_SOURCE_OFFSET){
+        return 0;
+    }
+
+    int low = 0;
+    if(line_hint != NULL && *line_hint > 0 && *line_hint < count && starts[*line_hint] <= offset){
+        low = *line_hint;
+        for(int step = 0; step < 4 && low + 1 < count && starts[low + 1] <= offset; step++){
+            low++;
+        }
+    }
+    int high = count - 1;
+    if(low + 1 < count && starts[low + 1] <= offset){
+        //largest line index in (low, high] starting at or before offset
+        while(low < high){
+            int mid = low + (high - low + 1) / 2;
+            if(starts[mid] <= offset){
+                low = mid;
+            } else {
+                high = mid - 1;
+            }
+        }
+    }
+    if(line_hint != NULL){
+        *line_hint = low;
+    }
+    return low + 1;
+}
+
+//where line starts, for diagnostics that only know their line
+unsigned int line_start_offset(const LineMap *map, int line){
+    if(line < 1 || line > map->count){
+        return NO_SOURCE_OFFSET;
+    }
+    return map->starts[line - 1];
+}
+
+//1-based byte column of offset on its line, as found by source_line; 0 when
+//the offset has no line
+int source_column(const LineMap *map, unsigned int offset, int line){
+    if(line < 1 || line > map->count){
+        return 0;
+    }
+    return (int)(offset - map->starts[line - 1]) + 1;
+}
+
+void clear_line_map(LineMap *map){
+    map->count = 0;
+}
+
+void free_line_map(LineMap *map){
+    free(map->starts);
+    map->starts = NULL;
+    map->count = 0;
+    map->capacity = 0;
+}
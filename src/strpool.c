@@ -0,0 +1,148 @@
+#include "../include/strpool.h"
+#include <string.h>
+#include <stdlib.h>
+
+//FNV-1a
+unsigned int hash_string(const char *text, size_t length){
+    unsigned int hash = 2166136261u;
+    for(size_t i = 0; i < length; i++){
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void grow_index(StringPool *pool){
+    int new_capacity = pool->capacity == 0 ? 256 : pool->capacity * 2;
+    StringEntry *entries = calloc((size_t)new_capacity, sizeof(StringEntry));
+    unsigned int mask = (unsigned int)new_capacity - 1;
+
+    for(int i = 0; i < pool->capacity; i++){
+        StringEntry *entry = &pool->entries[i];
+        if(entry->text == NULL){
+            continue;
+        }
+        unsigned int slot = entry->hash & mask;
+        while(entries[slot].text != NULL){
+            slot = (slot + 1) & mask;
+        }
+        entries[slot] = *entry;
+    }
+
+    free(pool->entries);
+    pool->entries = entries;
+    pool->capacity = new_capacity;
+}
+
+static int add_text(StringPool *pool, const char *text, unsigned int hash){
+    if(pool->count >= pool->text_capacity){
+        pool->text_capacity = pool->text_capacity == 0 ? 128 : pool->text_capacity * 2;
+        pool->texts = realloc(pool->texts, sizeof(const char *) * (size_t)pool->text_capacity);
+        pool->hashes = realloc(pool->hashes, sizeof(unsigned int) * (size_t)pool->text_capacity);
+    }
+    pool->texts[pool->count] = text;
+    pool->hashes[pool->count] = hash;
+    return pool->count++;
+}
+
+//id of a stable NUL terminated copy, equal strings share one copy and id
+int intern_string_id(StringPool *pool, const char *text, size_t length){
+    if((pool->count + 1) * 2 > pool->capacity){
+        grow_index(pool);
+    }
+
+    unsigned int hash = hash_string(text, length);
+    unsigned int mask = (unsigned int)pool->capacity - 1;
+    unsigned int slot = hash & mask;
+
+    while(pool->entries[slot].text != NULL){
+        StringEntry *entry = &pool->entries[slot];
+        if(entry->hash == hash && entry->length == length && memcmp(entry->text, text, length) == 0){
+            return entry->id;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    StringEntry *entry = &pool->entries[slot];
+    entry->text = arena_strndup(&pool->arena, text, length);
+    entry->length = (unsigned int)length;
+    entry->hash = hash;
+    entry->id = add_text(pool, entry->text, hash);
+    return entry->id;
+}
+
+const char *intern_string(StringPool *pool, const char *text, size_t length){
+    return pool->texts[intern_string_id(pool, text, length)];
+}
+
+//moves every string of `from` into `into`, leaving `from` empty. strings
+//keep their address; when both pools hold the same text, lookups return the
+//copy `into` already had. remap, if given, receives the id in `into` of
+//every id of `from`.
+void merge_string_pool(StringPool *into, StringPool *from, int *remap){
+    arena_merge(&into->arena, &from->arena);
+
+    for(int i = 0; i < from->capacity; i++){
+        StringEntry *entry = &from->entries[i];
+        if(entry->text == NULL){
+            continue;
+        }
+        if((into->count + 1) * 2 > into->capacity){
+            grow_index(into);
+        }
+        unsigned int mask = (unsigned int)into->capacity - 1;
+        unsigned int slot = entry->hash & mask;
+        int id = -1;
+        while(into->entries[slot].text != NULL){
+            StringEntry *existing = &into->entries[slot];
+            if(existing->hash == entry->hash && existing->length == entry->length
+               && memcmp(existing->text, entry->text, entry->length) == 0){
+                id = existing->id;
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        if(id < 0){
+            into->entries[slot] = *entry;
+            id = into->entries[slot].id = add_text(into, entry->text, entry->hash);
+        }
+        if(remap != NULL){
+            remap[entry->id] = id;
+        }
+    }
+
+    free(from->entries);
+    free(from->texts);
+    free(from->hashes);
+    from->entries = NULL;
+    from->texts = NULL;
+    from->hashes = NULL;
+    from->count = 0;
+    from->capacity = 0;
+    from->text_capacity = 0;
+}
+
+void clear_string_pool(StringPool *pool){
+    arena_reset(&pool->arena);
+    if(pool->entries != NULL){
+        memset(pool->entries, 0, sizeof(StringEntry) * (size_t)pool->capacity);
+    }
+    pool->count = 0;
+}
+
+void free_string_pool(StringPool *pool){
+    if(pool == NULL){
+        return;
+    }
+
+    arena_free(&pool->arena);
+    free(pool->entries);
+    free(pool->texts);
+    free(pool->hashes);
+    pool->entries = NULL;
+    pool->texts = NULL;
+    pool->hashes = NULL;
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->text_capacity = 0;
+}
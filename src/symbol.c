@@ -1,19 +1,40 @@
 #include "../include/symbol.h"
+#include "../include/strpool.h"
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
 
 Symbol create_symbol(const char *name, SymbolType type, int line_declared){
     Symbol symbol;
-    symbol.id = malloc(strlen(name)+1);
-    strcpy(symbol.id, name);
+    symbol.id = name; //copied into the table by add_symbol
     symbol.type = type;
     symbol.line_declared = line_declared;
-    symbol.value = NULL;
+    symbol.value = undefined_value();
+    symbol.assigned = 0;
     return symbol;
 };
 
 
+static void index_insert(SymbolTable *table, int position){
+    const char *id = table->symbols[position].id;
+    unsigned int mask = (unsigned int)table->index_capacity - 1;
+    unsigned int slot = hash_string(id, strlen(id)) & mask;
+    while(table->index[slot] != 0){
+        slot = (slot + 1) & mask;
+    }
+    table->index[slot] = position + 1;
+}
+
+static void grow_index(SymbolTable *table){
+    int new_capacity = table->index_capacity == 0 ? 32 : table->index_capacity * 2;
+    free(table->index);
+    table->index = calloc((size_t)new_capacity, sizeof(int));
+    table->index_capacity = new_capacity;
+    for(int i = 0; i < table->count; i++){
+        index_insert(table, i);
+    }
+}
+
 void add_symbol(SymbolTable *table, Symbol symbol){
     if(table->capacity == 0){
         table->capacity = 10;
@@ -24,32 +45,72 @@ void add_symbol(SymbolTable *table, Symbol symbol){
         table->capacity *= 2;
         table->symbols = realloc(table->symbols, sizeof(Symbol) * table->capacity);
     }
+    symbol.id = arena_strdup(&table->ids, symbol.id);
     table->symbols[table->count++] = symbol;
+
+    if(table->count * 2 > table->index_capacity){
+        grow_index(table);
+    } else {
+        index_insert(table, table->count - 1);
+    }
 };
 
 Symbol* findSymbol(SymbolTable *table, const char *id){
+    return findSymbolHashed(table, id, hash_string(id, strlen(id)));
+};
 
-    for(int i=0 ; i < table->count; i++){
-        if(strcmp(table->symbols[i].id, id) == 0)
-        return &table->symbols[i];
+//for callers that already know hash_string of id, such as interned token text
+Symbol* findSymbolHashed(SymbolTable *table, const char *id, unsigned int hash){
+    if(table->index_capacity == 0){
+        return NULL;
+    }
+
+    unsigned int mask = (unsigned int)table->index_capacity - 1;
+    unsigned int slot = hash & mask;
+    while(table->index[slot] != 0){
+        Symbol *sym = &table->symbols[table->index[slot] - 1];
+        if(strcmp(sym->id, id) == 0){
+            return sym;
+        }
+        slot = (slot + 1) & mask;
     }
     return NULL;
 };
 
-void free_symbol_table(SymbolTable *table){
-    if(table == NULL || table->symbols == NULL){
+//drops every symbol from position count on, used to roll back a re-parse
+void truncate_symbol_table(SymbolTable *table, int count){
+    if(count >= table->count){
         return;
     }
+    arena_rewind(&table->ids, table->symbols[count].id);
+    table->count = count;
 
-    for(int i=0 ; i< table->count; i++){
-        free(table->symbols[i].id);
-        if(table->symbols[i].value){
-            free(table->symbols[i].value);
-        }
+    memset(table->index, 0, sizeof(int) * (size_t)table->index_capacity);
+    for(int i = 0; i < table->count; i++){
+        index_insert(table, i);
+    }
+}
+
+//empties the table but keeps the arrays, the index and the ids' memory
+void clear_symbol_table(SymbolTable *table){
+    arena_reset(&table->ids);
+    table->count = 0;
+    if(table->index != NULL){
+        memset(table->index, 0, sizeof(int) * (size_t)table->index_capacity);
+    }
+}
+
+void free_symbol_table(SymbolTable *table){
+    if(table == NULL || table->symbols == NULL){
+        return;
     }
 
+    arena_free(&table->ids);
     free(table->symbols);
+    free(table->index);
     table->symbols = NULL;
     table->count = 0;
     table->capacity = 0;
+    table->index = NULL;
+    table->index_capacity = 0;
 };
\ No newline at end of file
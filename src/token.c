@@ -3,44 +3,235 @@
 #include <string.h>
 #include <stdlib.h>
 
-Token create_token(TokenType type, const char *value, int line){
-    Token token;
-    token.type = type;
-    token.line = line;
-    //allocate just enough space for the value 
-    token.value = malloc(strlen(value)+1);
-    strcpy(token.value, value);
+//fixed text of keywords and punctuation, these tokens carry no string storage
+const char *token_spelling(TokenType type){
+    switch(type){
+        case KEYWORD_BEGIN: return "FRG_Begin";
+        case KEYWORD_END: return "FRG_End";
+        case KEYWORD_INT: return "FRG_Int";
+        case KEYWORD_REAL: return "FRG_Real";
+        case KEYWORD_STRING: return "FRG_Strg";
+        case KEYWORD_PRINT: return "FRG_Print";
+        case KEYWORD_IF: return "If";
+        case KEYWORD_ELSE: return "Else";
+        case KEYWORD_REPEAT: return "Repeat";
+        case KEYWORD_UNTIL: return "until";
+        case BLOCK_BEGIN: return "Begin";
+        case BLOCK_END: return "End";
+        case ASSIGN_OP: return ":=";
+        case END_INSTRUCTION: return "#";
+        case COMMA: return ",";
+        case OPEN_BRACKET: return "[";
+        case CLOSE_BRACKET: return "]";
+        case OPEN_PAREN: return "(";
+        case CLOSE_PAREN: return ")";
+        case OPERATOR_PLUS: return "+";
+        case OPERATOR_MINUS: return "-";
+        case OPERATOR_MULTIPLY: return "*";
+        case OPERATOR_DIVIDE: return "/";
+        default: return "";
+    }
+}
 
-    return token;
+static void grow_columns(TokenList *list, int capacity){
+    size_t blocks = (size_t)capacity / 64 + 1;
+    list->capacity = capacity;
+    list->kinds = realloc(list->kinds, (size_t)capacity);
+    list->offsets = realloc(list->offsets, sizeof(unsigned int) * (size_t)capacity);
+    list->text_bits = realloc(list->text_bits, sizeof(unsigned long long) * blocks);
+    list->text_ranks = realloc(list->text_ranks, sizeof(int) * blocks);
 }
 
-void add_token(TokenList *list, Token token){
-    //if list is empty initialize space in memory
-    if(list->tokens == NULL){
-        list->capacity = 10;
-        list->count = 0;
-        list->tokens = malloc(sizeof(Token)* list->capacity);
+static void reserve_texts(TokenList *list, int capacity){
+    if(capacity <= list->text_capacity){
+        return;
+    }
+    while(list->text_capacity < capacity){
+        list->text_capacity = list->text_capacity == 0 ? 16 : list->text_capacity * 2;
     }
+    list->texts = realloc(list->texts, sizeof(int) * (size_t)list->text_capacity);
+}
 
+//rebuilds text_bits and text_ranks from the kinds of the tokens from `from`
+//on; the ones before it must be indexed already
+static void index_texts(TokenList *list, int from){
+    int block = from >> 6;
+    int rank = block == 0 ? 0 : list->text_ranks[block - 1] + __builtin_popcountll(list->text_bits[block - 1]);
+    for(int i = block << 6; i < list->count; i++){
+        if((i & 63) == 0){
+            list->text_bits[i >> 6] = 0;
+            list->text_ranks[i >> 6] = rank;
+        }
+        if(token_has_text((TokenType)list->kinds[i])){
+            list->text_bits[i >> 6] |= 1ULL << (i & 63);
+            rank++;
+        }
+    }
+    list->text_count = rank;
+}
+
+//text is the pool id of the token's text, ignored for kinds without text
+void add_token(TokenList *list, TokenType type, unsigned int offset, int text){
     if(list->count >= list->capacity){
-        list->capacity *= 2;
-        list->tokens = realloc(list->tokens, sizeof(Token)* list->capacity);
+        grow_columns(list, list->capacity == 0 ? 16 : list->capacity * 2);
+    }
+
+    int index = list->count++;
+    if((index & 63) == 0){
+        list->text_bits[index >> 6] = 0;
+        list->text_ranks[index >> 6] = list->text_count;
+    }
+    list->kinds[index] = (unsigned char)type;
+    list->offsets[index] = offset;
+    if(token_has_text(type)){
+        reserve_texts(list, list->text_count + 1);
+        list->texts[list->text_count++] = text;
+        list->text_bits[index >> 6] |= 1ULL << (index & 63);
     }
-    list->tokens[list->count++] = token;
-    
 }
 
-void free_token_list(TokenList *list){
-    if(list == NULL || list->tokens == NULL){
+//Moves the tokens of `from` past its first `first` ones to the end of list,
+//together with all of from's strings and lines. Offsets are kept as they
+//are, so from must have been lexed from the same buffer, right after list.
+void append_tokens(TokenList *list, TokenList *from, int first){
+    int base = list->count;
+    int moved = from->count - first;
+    if(moved < 0){
+        moved = 0;
+    }
+    if(base + moved > list->capacity){
+        int capacity = list->capacity == 0 ? 16 : list->capacity;
+        while(capacity < base + moved){
+            capacity *= 2;
+        }
+        grow_columns(list, capacity);
+    }
+
+    for(int i = 0; i < from->lines.count; i++){
+        add_line_start(&list->lines, from->lines.starts[i]);
+    }
+
+    int *remap = malloc(sizeof(int) * (size_t)(from->strings.count > 0 ? from->strings.count : 1));
+    merge_string_pool(&list->strings, &from->strings, remap);
+    int first_text = token_text_rank(from, first);
+    reserve_texts(list, list->text_count + from->text_count - first_text);
+    for(int i = first_text; i < from->text_count; i++){
+        list->texts[list->text_count++] = remap[from->texts[i]];
+    }
+    free(remap);
+
+    if(moved > 0){
+        memcpy(list->kinds + base, from->kinds + first, (size_t)moved);
+        memcpy(list->offsets + base, from->offsets + first, sizeof(unsigned int) * (size_t)moved);
+    }
+    list->count = base + moved;
+    index_texts(list, base);
+}
+
+//moves items [fresh_start, end) to `at`, over the `removed` items there,
+//shifting the ones in between
+static void rotate_items(void *items, size_t size, int at, int removed, int fresh_start, int end){
+    if(items == NULL){
         return;
     }
+    char *base = items;
+    size_t fresh = (size_t)(end - fresh_start) * size;
+    size_t suffix = (size_t)(fresh_start - at - removed) * size;
+    char *moved = malloc(fresh > 0 ? fresh : 1);
+    memcpy(moved, base + (size_t)fresh_start * size, fresh);
+    memmove(base + (size_t)at * size + fresh, base + (size_t)(at + removed) * size, suffix);
+    memcpy(base + (size_t)at * size, moved, fresh);
+    free(moved);
+}
 
-    for(int i = 0; i < list->count; i++){
-        free(list->tokens[i].value);
+//moves the tokens appended at fresh_start to position `at`, over the
+//`removed` stale tokens that were there. The line map is left alone, the
+//caller knows the lines and rebuilds it.
+void rotate_tokens(TokenList *list, int at, int removed, int fresh_start){
+    if(list->count == 0){
+        return;
     }
+    int text_at = token_text_rank(list, at);
+    int text_removed = token_text_rank(list, at + removed) - text_at;
+    int text_fresh = token_text_rank(list, fresh_start);
+    rotate_items(list->texts, sizeof(int), text_at, text_removed, text_fresh, list->text_count);
 
-    free(list->tokens);
-    list->tokens = NULL;
+    int end = list->count;
+    rotate_items(list->kinds, 1, at, removed, fresh_start, end);
+    rotate_items(list->offsets, sizeof(unsigned int), at, removed, fresh_start, end);
+    list->count = end - removed;
+    index_texts(list, at);
+}
+
+//finds line_end for a cursor that has just moved to a new line; lines hold
+//a handful of tokens, so this is a short forward scan
+void token_cursor_line_end(const TokenList *list, TokenCursor *cursor){
+    if(cursor->line + 1 >= list->lines.count){
+        cursor->line_end = INT_MAX;
+        return;
+    }
+    unsigned int next = list->lines.starts[cursor->line + 1];
+    int end = cursor->index;
+    while(end < list->count && list->offsets[end] < next){
+        end++;
+    }
+    cursor->line_end = end;
+}
+
+void token_cursor_seek(const TokenList *list, TokenCursor *cursor, int index){
+    int line = cursor->index <= index ? cursor->line : 0;
+    cursor->text = cursor->index == index ? cursor->text : token_text_rank(list, index);
+    cursor->index = index;
+    if(index >= list->count || line_map_search(&list->lines, list->offsets[index], &line) == 0){
+        line = 0;
+    }
+    cursor->line = line;
+    token_cursor_line_end(list, cursor);
+}
+
+//bytes held by the token columns and the line map, not counting the
+//strings themselves
+size_t token_list_footprint(const TokenList *list){
+    size_t blocks = list->capacity > 0 ? (size_t)list->capacity / 64 + 1 : 0;
+    return (size_t)list->capacity * (1 + sizeof(unsigned int))
+           + blocks * (sizeof(unsigned long long) + sizeof(int))
+           + (size_t)list->text_capacity * sizeof(int)
+           + (size_t)list->lines.capacity * sizeof(unsigned int);
+}
+
+//generous guess from typical FROG code, about one token per 4-5 bytes, so a
+//list reserved with it rarely has to grow
+int estimate_token_count(size_t source_length){
+    size_t estimate = source_length / 4 + 16;
+    return estimate > (size_t)(1 << 30) ? 1 << 30 : (int)estimate;
+}
+
+void reserve_token_list(TokenList *list, int capacity){
+    if(capacity <= list->capacity){
+        return;
+    }
+    grow_columns(list, capacity);
+}
+
+//empties the list but keeps its columns and the pool's memory for the next run
+void clear_token_list(TokenList *list){
     list->count = 0;
-    list->capacity = 0;
-}
\ No newline at end of file
+    list->text_count = 0;
+    clear_line_map(&list->lines);
+    clear_string_pool(&list->strings);
+}
+
+void free_token_list(TokenList *list){
+    if(list == NULL){
+        return;
+    }
+
+    free(list->kinds);
+    free(list->offsets);
+    free(list->texts);
+    free(list->text_bits);
+    free(list->text_ranks);
+    free_line_map(&list->lines);
+    free_string_pool(&list->strings);
+    memset(list, 0, sizeof(*list));
+}
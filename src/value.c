@@ -0,0 +1,76 @@
+#include "../include/value.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Value undefined_value(void){
+    Value value;
+    value.type = KEY_UNKNOWN;
+    value.as.i = 0;
+    return value;
+}
+
+Value int_value(long long i){
+    Value value;
+    value.type = KEY_INT;
+    value.as.i = i;
+    return value;
+}
+
+Value real_value(double r){
+    Value value;
+    value.type = KEY_REAL;
+    value.as.r = r;
+    return value;
+}
+
+Value string_value(const char *s){
+    Value value;
+    value.type = KEY_STRING;
+    value.as.s = s;
+    return value;
+}
+
+int value_is_number(const Value *value){
+    return value->type == KEY_INT || value->type == KEY_REAL;
+}
+
+double value_as_real(const Value *value){
+    return value->type == KEY_INT ? (double)value->as.i : value->as.r;
+}
+
+//sets *cmp to <0, 0 or >0; returns 0 when the values cannot be compared
+int compare_values(const Value *lhs, const Value *rhs, int *cmp){
+    if(lhs->type == KEY_STRING && rhs->type == KEY_STRING){
+        *cmp = strcmp(lhs->as.s, rhs->as.s);
+    } else if(lhs->type == KEY_INT && rhs->type == KEY_INT){
+        *cmp = (lhs->as.i > rhs->as.i) - (lhs->as.i < rhs->as.i);
+    } else if(value_is_number(lhs) && value_is_number(rhs)){
+        double l = value_as_real(lhs);
+        double r = value_as_real(rhs);
+        *cmp = (l > r) - (l < r);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+//text for display only; reals use the shortest form that reads back to the
+//same double. Returns NULL for undefined values.
+const char *format_value(const Value *value, char *buffer, size_t size){
+    switch(value->type){
+        case KEY_INT:
+            snprintf(buffer, size, "%lld", value->as.i);
+            return buffer;
+        case KEY_REAL:
+            snprintf(buffer, size, "%.15g", value->as.r);
+            if(strtod(buffer, NULL) != value->as.r){
+                snprintf(buffer, size, "%.17g", value->as.r);
+            }
+            return buffer;
+        case KEY_STRING:
+            return value->as.s;
+        default:
+            return NULL;
+    }
+}